@@ -0,0 +1,249 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#include "WesternWar.h"
+#include "ActorPool.h"
+#include "Interfaces/PooledActorInterface.h"
+
+FActorPoolClassData& UActorPool::FindOrAddClassData(TSubclassOf<AActor> ActorClass)
+{
+	for (FActorPoolClassData& ClassData : PooledClasses)
+	{
+		if (ClassData.ActorClass == ActorClass)
+		{
+			return ClassData;
+		}
+	}
+
+	FActorPoolClassData& NewClassData = PooledClasses[PooledClasses.AddDefaulted()];
+	NewClassData.ActorClass = ActorClass;
+
+	return NewClassData;
+}
+
+FActorPoolClassData* UActorPool::FindClassData(TSubclassOf<AActor> ActorClass)
+{
+	for (FActorPoolClassData& ClassData : PooledClasses)
+	{
+		if (ClassData.ActorClass == ActorClass)
+		{
+			return &ClassData;
+		}
+	}
+
+	return nullptr;
+}
+
+const FActorPoolClassData* UActorPool::FindClassData(TSubclassOf<AActor> ActorClass) const
+{
+	for (const FActorPoolClassData& ClassData : PooledClasses)
+	{
+		if (ClassData.ActorClass == ActorClass)
+		{
+			return &ClassData;
+		}
+	}
+
+	return nullptr;
+}
+
+AActor* UActorPool::SpawnPooledActor(TSubclassOf<AActor> ActorClass)
+{
+	UWorld* World = GetWorld();
+
+	if (!World || !*ActorClass)
+	{
+		return nullptr;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	AActor* Actor = World->SpawnActor<AActor>(ActorClass, FTransform::Identity, SpawnParams);
+
+	if (Actor)
+	{
+		FindOrAddClassData(ActorClass).TotalSpawned++;
+	}
+
+	return Actor;
+}
+
+//Hide the actor and stop it from costing anything while it sits in the pool
+void UActorPool::DeactivateActor(AActor* Actor)
+{
+	Actor->SetActorHiddenInGame(true);
+	Actor->SetActorEnableCollision(false);
+	Actor->SetActorTickEnabled(false);
+	Actor->SetOwner(nullptr);
+	Actor->DetachRootComponentFromParent();
+}
+
+void UActorPool::ActivateActor(AActor* Actor, const FTransform& Transform, AActor* NewOwner)
+{
+	Actor->SetActorTransform(Transform, false, nullptr, ETeleportType::TeleportPhysics);
+	Actor->SetOwner(NewOwner);
+	Actor->SetActorHiddenInGame(false);
+	Actor->SetActorEnableCollision(true);
+	//Same tick state as the actor had when it was spawned
+	Actor->SetActorTickEnabled(Actor->PrimaryActorTick.bCanEverTick && Actor->PrimaryActorTick.bStartWithTickEnabled);
+}
+
+//Spawn actors ahead of time so no spawning has to happen during the match
+void UActorPool::Prewarm(TSubclassOf<AActor> ActorClass, int32 Count)
+{
+	if (!*ActorClass)
+	{
+		return;
+	}
+
+	for (int32 i = 0; i < Count; i++)
+	{
+		AActor* Actor = SpawnPooledActor(ActorClass);
+
+		if (Actor)
+		{
+			DeactivateActor(Actor);
+			FindOrAddClassData(ActorClass).FreeActors.Add(Actor);
+		}
+	}
+}
+
+/*
+* Hand out an actor from the pool, if the pool of the class is empty a new actor is spawned
+* - The pool grows instead of failing, the high-water mark shows how large the prewarm count should be
+*/
+AActor* UActorPool::AcquireActor(TSubclassOf<AActor> ActorClass, const FTransform& Transform, AActor* NewOwner)
+{
+	if (!*ActorClass)
+	{
+		return nullptr;
+	}
+
+	AActor* Actor = nullptr;
+
+	FActorPoolClassData& ClassData = FindOrAddClassData(ActorClass);
+
+	while (!Actor && ClassData.FreeActors.Num() > 0)
+	{
+		//Actors destroyed by something other than the pool are skipped
+		Actor = ClassData.FreeActors.Pop(false);
+
+		if (Actor && Actor->IsPendingKill())
+		{
+			Actor = nullptr;
+		}
+	}
+
+	if (!Actor)
+	{
+		Actor = SpawnPooledActor(ActorClass);
+
+		if (!Actor)
+		{
+			return nullptr;
+		}
+	}
+
+	//Handed out actors destroyed by something other than the pool are nulled by the garbage collector
+	ClassData.ActiveActors.RemoveSwap(nullptr);
+	ClassData.ActiveActors.Add(Actor);
+	ClassData.HighWaterMark = FMath::Max(ClassData.HighWaterMark, ClassData.ActiveActors.Num());
+
+	ActivateActor(Actor, Transform, NewOwner);
+
+	if (Actor->GetClass()->ImplementsInterface(UPooledActorInterface::StaticClass()))
+	{
+		IPooledActorInterface::Execute_OnAcquiredFromPool(Actor);
+	}
+
+	return Actor;
+}
+
+//Return an actor to the pool instead of destroying it
+void UActorPool::ReleaseActor(AActor* Actor)
+{
+	if (!Actor || Actor->IsPendingKill())
+	{
+		return;
+	}
+
+	FActorPoolClassData* ClassData = FindClassData(Actor->GetClass());
+
+	//Actors the pool never handed out would be counted twice or end up in the free list while still in use
+	if (!ClassData || ClassData->ActiveActors.RemoveSwap(Actor) == 0)
+	{
+		UE_LOG(LogWesternWar, Warning, TEXT("Actor Pool | %s was not handed out by the pool and is not released"), *GetNameSafe(Actor));
+		return;
+	}
+
+	if (Actor->GetClass()->ImplementsInterface(UPooledActorInterface::StaticClass()))
+	{
+		IPooledActorInterface::Execute_OnReturnedToPool(Actor);
+	}
+
+	DeactivateActor(Actor);
+
+	ClassData->FreeActors.Add(Actor);
+}
+
+void UActorPool::AdoptActor(AActor* Actor)
+{
+	if (!Actor || Actor->IsPendingKill())
+	{
+		return;
+	}
+
+	FActorPoolClassData& ClassData = FindOrAddClassData(Actor->GetClass());
+
+	if (ClassData.ActiveActors.Contains(Actor) || ClassData.FreeActors.Contains(Actor))
+	{
+		return;
+	}
+
+	ClassData.ActiveActors.Add(Actor);
+	ClassData.HighWaterMark = FMath::Max(ClassData.HighWaterMark, ClassData.ActiveActors.Num());
+	ClassData.TotalAdopted++;
+}
+
+void UActorPool::EmptyPool()
+{
+	for (FActorPoolClassData& ClassData : PooledClasses)
+	{
+		for (AActor* Actor : ClassData.FreeActors)
+		{
+			if (Actor && !Actor->IsPendingKill())
+			{
+				Actor->Destroy();
+			}
+		}
+	}
+
+	PooledClasses.Empty();
+}
+
+int32 UActorPool::GetHighWaterMark(TSubclassOf<AActor> ActorClass) const
+{
+	const FActorPoolClassData* ClassData = FindClassData(ActorClass);
+	return ClassData ? ClassData->HighWaterMark : 0;
+}
+
+int32 UActorPool::GetActiveCount(TSubclassOf<AActor> ActorClass) const
+{
+	const FActorPoolClassData* ClassData = FindClassData(ActorClass);
+	return ClassData ? ClassData->ActiveActors.Num() : 0;
+}
+
+int32 UActorPool::GetFreeCount(TSubclassOf<AActor> ActorClass) const
+{
+	const FActorPoolClassData* ClassData = FindClassData(ActorClass);
+	return ClassData ? ClassData->FreeActors.Num() : 0;
+}
+
+void UActorPool::LogPoolStats() const
+{
+	for (const FActorPoolClassData& ClassData : PooledClasses)
+	{
+		UE_LOG(LogWesternWar, Log, TEXT("Actor Pool | %s | Active: %d | Free: %d | High-Water Mark: %d | Total Spawned: %d | Total Adopted: %d"),
+			*GetNameSafe(*ClassData.ActorClass), ClassData.ActiveActors.Num(), ClassData.FreeActors.Num(), ClassData.HighWaterMark, ClassData.TotalSpawned, ClassData.TotalAdopted);
+	}
+}
@@ -0,0 +1,87 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#pragma once
+
+#include "Object.h"
+#include "ActorPool.generated.h"
+
+USTRUCT(BlueprintType)
+struct FActorPoolPrewarmData
+{
+	//Actor class and how many of them should be spawned into the pool when the map loads
+
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Actor Pool")
+		TSubclassOf<AActor> ActorClass;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Actor Pool")
+		int32 Count = 0;
+};
+
+USTRUCT()
+struct FActorPoolClassData
+{
+	//Pooled actors of a single class
+
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY()
+		TSubclassOf<AActor> ActorClass;
+	UPROPERTY()
+		TArray<AActor*> FreeActors;
+	UPROPERTY()
+		TArray<AActor*> ActiveActors;	//Handed out or adopted, only these can be released into the pool
+
+	int32 HighWaterMark = 0;	//Max number of actors of this class that were in use at the same time
+	int32 TotalSpawned = 0;
+	int32 TotalAdopted = 0;
+};
+
+/*
+* Actor Pool - Keeps inactive actors around instead of destroying them
+* - Actors are prewarmed at map load and handed out with AcquireActor
+* - ReleaseActor hides the actor, disables collision & ticking and puts it back in the pool
+* - Only actors the pool handed out can be released, actors spawned elsewhere have to be adopted first
+* - Actors implementing IPooledActorInterface get reset hooks on acquire & release
+*/
+UCLASS()
+class WESTERNWAR_API UActorPool : public UObject
+{
+	GENERATED_BODY()
+
+private:
+	UPROPERTY()
+		TArray<FActorPoolClassData> PooledClasses;
+
+	FActorPoolClassData& FindOrAddClassData(TSubclassOf<AActor> ActorClass);
+	FActorPoolClassData* FindClassData(TSubclassOf<AActor> ActorClass);
+	const FActorPoolClassData* FindClassData(TSubclassOf<AActor> ActorClass) const;
+
+	AActor* SpawnPooledActor(TSubclassOf<AActor> ActorClass);
+	void DeactivateActor(AActor* Actor);
+	void ActivateActor(AActor* Actor, const FTransform& Transform, AActor* NewOwner);
+
+public:
+	void Prewarm(TSubclassOf<AActor> ActorClass, int32 Count);
+
+	AActor* AcquireActor(TSubclassOf<AActor> ActorClass, const FTransform& Transform, AActor* NewOwner = nullptr);
+	void ReleaseActor(AActor* Actor);
+
+	//Take over an actor the pool did not spawn (a dropped item), it counts as handed out & can be released from then on
+	void AdoptActor(AActor* Actor);
+
+	template<class T>
+	T* AcquireActor(TSubclassOf<AActor> ActorClass, const FTransform& Transform, AActor* NewOwner = nullptr)
+	{
+		return Cast<T>(AcquireActor(ActorClass, Transform, NewOwner));
+	}
+
+	//Destroy every actor held by the pool (called when the world is torn down)
+	void EmptyPool();
+
+	int32 GetHighWaterMark(TSubclassOf<AActor> ActorClass) const;
+	int32 GetActiveCount(TSubclassOf<AActor> ActorClass) const;
+	int32 GetFreeCount(TSubclassOf<AActor> ActorClass) const;
+
+	void LogPoolStats() const;
+};
@@ -2,7 +2,188 @@
 
 #include "WesternWar.h"
 #include "MainGameState.h"
+#include "Networking/NetTrafficStats.h"
+#include "Networking/NetcodeTimingStats.h"
+#include "Networking/ServerLoadStats.h"
+#include "Player/MainPlayerController.h"
+#include "UnrealNetwork.h"
 
 
+AMainGameState::AMainGameState()
+{
+	//Ticks the per frame netcode traffic & timing stats, records the world snapshot & resolves the melee swings
+	//After the pawns, so the snapshot holds the result of this frames simulation
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+}
 
+void AMainGameState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
+	DOREPLIFETIME(AMainGameState, ServerTick);
+}
+
+void AMainGameState::BeginPlay()
+{
+	Super::BeginPlay();
+
+	ActorPool = NewObject<UActorPool>(this);
+
+	for (const FActorPoolPrewarmData& PrewarmData : PoolPrewarmList)
+	{
+		if (!*PrewarmData.ActorClass)
+		{
+			continue;
+		}
+
+		//Replicated actors are only pooled on the server, clients receive them through replication
+		if (PrewarmData.ActorClass->GetDefaultObject<AActor>()->GetIsReplicated() && Role != ROLE_Authority)
+		{
+			continue;
+		}
+
+		ActorPool->Prewarm(PrewarmData.ActorClass, PrewarmData.Count);
+	}
+
+	//Items only exist on the server, clients see the materialized actors through replication
+	if (Role == ROLE_Authority)
+	{
+		WorldItemRegistry = NewObject<UWorldItemRegistry>(this);
+
+		for (const FWorldItemSpawnData& SpawnData : WorldItemSpawnList)
+		{
+			WorldItemRegistry->AddItem(SpawnData.ItemClass, SpawnData.Transform);
+		}
+
+		GetWorldTimerManager().SetTimer(WorldItemUpdateTimerHandle, FTimerDelegate::CreateUObject(WorldItemRegistry, &UWorldItemRegistry::UpdateMaterializedItems), WorldItemUpdateInterval, true);
+	}
+
+	FNetTrafficStats::Get().Reset();
+	FServerLoadStats::Get().Reset();
+}
+
+void AMainGameState::Tick(float DeltaSeconds)
+{
+	//Measured here instead of read from GGameThreadTime, which is only filled in by the stats & is 0 on a dedicated server
+	const uint32 TickStartCycles = FPlatformTime::Cycles();
+
+	Super::Tick(DeltaSeconds);
+
+	if (Role == ROLE_Authority)
+	{
+		ServerTick++;
+		SnapshotHistory.RecordTick(ServerTick, GetWorld()->GetTimeSeconds());
+		MeleeSwingResolver.ResolveSwings(ServerTick, GetWorld()->GetTimeSeconds(), SnapshotHistory);
+		KillcamHistory.RecordTick(ServerTick, GetWorld()->GetTimeSeconds(), SnapshotHistory);
+	}
+
+	FNetcodeTimingStats::Get().EndFrame();
+
+	//Server frame time against the connected players (bot load tests)
+	if (Role == ROLE_Authority && GetNetMode() != NM_Standalone)
+	{
+		const float ServerTickMilliseconds = FPlatformTime::ToMilliseconds(FPlatformTime::Cycles() - TickStartCycles);
+		FServerLoadStats::Get().RecordFrame(PlayerArray.Num(), ServerTickMilliseconds, FNetcodeTimingStats::Get().GetLastFrameMilliseconds());
+	}
+
+	FNetTrafficStats& NetStats = FNetTrafficStats::Get();
+	NetStats.Tick(DeltaSeconds, GetNetDriver());
+
+	if (FNetTrafficStats::IsOnScreenDisplayEnabled() && GEngine)
+	{
+		TArray<FString> Lines;
+		NetStats.GetSummaryLines(Lines);
+
+		//Fixed keys so the lines are replaced every frame instead of stacking
+		for (int32 i = 0; i < Lines.Num(); i++)
+		{
+			GEngine->AddOnScreenDebugMessage(1000 + i, 0, FColor::Cyan, Lines[i]);
+		}
+	}
+}
+
+void AMainGameState::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	MeleeSwingResolver.Reset();
+	KillcamHistory.Reset();
+
+	GetWorldTimerManager().ClearTimer(WorldItemUpdateTimerHandle);
+
+	if (WorldItemRegistry)
+	{
+		WorldItemRegistry->LogRegistryStats();
+	}
+
+	if (ActorPool)
+	{
+		ActorPool->LogPoolStats();
+		ActorPool->EmptyPool();
+	}
+
+	if (FNetTrafficStats::IsAutoExportEnabled())
+	{
+		FNetTrafficStats::Get().LogStats();
+		FNetTrafficStats::Get().ExportCsv(FNetTrafficStats::GetSessionCsvPath(GetWorld()));
+
+		if (FServerLoadStats::Get().HasFrames())
+		{
+			FServerLoadStats::Get().LogStats();
+			FServerLoadStats::Get().ExportCsv(FServerLoadStats::GetSessionCsvPath());
+		}
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AMainGameState::SendKillcam(AMainPlayerController* Victim, float Seconds)
+{
+	if (Role != ROLE_Authority || !Victim)
+	{
+		return;
+	}
+
+	//The pawns that held the slots during the clip, the client maps them to its own copies of the pawns
+	TArray<uint8> Clip;
+	TArray<APawn*> ClipPawns;
+
+	if (!KillcamHistory.ExtractClip(Seconds, Clip, ClipPawns))
+	{
+		return;
+	}
+
+	Victim->SendKillcamClip(ClipPawns, Clip);
+}
+
+FWorldSnapshotHistory* AMainGameState::GetWorldSnapshotHistory(const UObject* WorldContextObject)
+{
+	UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	AMainGameState* MainGameState = World ? Cast<AMainGameState>(World->GetGameState()) : nullptr;
+
+	return MainGameState ? &MainGameState->GetSnapshotHistory() : nullptr;
+}
+
+UWorldItemRegistry* AMainGameState::GetWorldItemRegistry(const UObject* WorldContextObject)
+{
+	UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	AMainGameState* MainGameState = World ? Cast<AMainGameState>(World->GetGameState()) : nullptr;
+
+	return MainGameState ? MainGameState->GetItemRegistry() : nullptr;
+}
+
+UActorPool* AMainGameState::GetWorldActorPool(const UObject* WorldContextObject)
+{
+	UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+
+	if (World)
+	{
+		AMainGameState* MainGameState = Cast<AMainGameState>(World->GetGameState());
+
+		if (MainGameState)
+		{
+			return MainGameState->GetActorPool();
+		}
+	}
+
+	return nullptr;
+}
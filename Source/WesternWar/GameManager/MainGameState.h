@@ -3,6 +3,11 @@
 #pragma once
 
 #include "GameFramework/GameState.h"
+#include "ActorPool.h"
+#include "WorldSnapshotHistory.h"
+#include "WorldItemRegistry.h"
+#include "Weapons/MeleeSwingResolver.h"
+#include "Networking/KillcamHistory.h"
 #include "MainGameState.generated.h"
 
 /**
@@ -12,8 +17,70 @@ UCLASS()
 class WESTERNWAR_API AMainGameState : public AGameState
 {
 	GENERATED_BODY()
-	
-	
-	
+
+private:
+	UPROPERTY()
+		UActorPool *ActorPool;
+
+	//Authoritative tick number, incremented once per server frame
+	UPROPERTY(Replicated)
+		int32 ServerTick = 0;
+
+	FWorldSnapshotHistory SnapshotHistory;
+	FMeleeSwingResolver MeleeSwingResolver;
+	FKillcamHistory KillcamHistory;
+
+	UPROPERTY()
+		UWorldItemRegistry *WorldItemRegistry;
+
+	FTimerHandle WorldItemUpdateTimerHandle;
+
+public:
+	AMainGameState();
+
+	virtual void BeginPlay() override;
+	virtual void Tick(float DeltaSeconds) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	UFUNCTION(BlueprintCallable, Category = "Actor Pool")
+		UActorPool* GetActorPool() const { return ActorPool; }
+
+	//Returns the actor pool of the world the context object is in
+	static UActorPool* GetWorldActorPool(const UObject* WorldContextObject);
+
+	int32 GetServerTick() const { return ServerTick; }
+
+	//Transforms of every registered pawn for the last server ticks (server only)
+	FWorldSnapshotHistory& GetSnapshotHistory() { return SnapshotHistory; }
+
+	//Returns the snapshot history of the world the context object is in
+	static FWorldSnapshotHistory* GetWorldSnapshotHistory(const UObject* WorldContextObject);
+
+	//Active melee swings, resolved against the snapshot history every server tick (server only)
+	FMeleeSwingResolver& GetMeleeSwingResolver() { return MeleeSwingResolver; }
+
+	//Compressed pawn states & fire events of the last seconds (server only)
+	FKillcamHistory& GetKillcamHistory() { return KillcamHistory; }
+
+	//Streams the last seconds of the killcam history to the players client, which plays it back on the recorded server times
+	UFUNCTION(BlueprintCallable, Category = "Killcam")
+		void SendKillcam(class AMainPlayerController* Victim, float Seconds = 5);
+
+	//Items lying in the world (server only)
+	UFUNCTION(BlueprintCallable, Category = "World Items")
+		UWorldItemRegistry* GetItemRegistry() const { return WorldItemRegistry; }
+
+	//Returns the world item registry of the world the context object is in
+	static UWorldItemRegistry* GetWorldItemRegistry(const UObject* WorldContextObject);
+
+	//Items added to the world item registry at map load
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "World Items")
+		TArray<FWorldItemSpawnData> WorldItemSpawnList;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "World Items")
+		float WorldItemUpdateInterval = 0.25f;
+
+	//Actors spawned into the pool at map load, so transient actors are never spawned mid match
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Actor Pool")
+		TArray<FActorPoolPrewarmData> PoolPrewarmList;
 	
 };
@@ -0,0 +1,311 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#include "WesternWar.h"
+#include "WorldItemRegistry.h"
+#include "MainGameState.h"
+
+FIntPoint UWorldItemRegistry::GetCell(const FVector& Location)
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / WORLD_ITEM_GRID_CELL_SIZE), FMath::FloorToInt(Location.Y / WORLD_ITEM_GRID_CELL_SIZE));
+}
+
+FWorldItem* UWorldItemRegistry::FindItem(int32 ItemID)
+{
+	const int32* Index = ItemIndices.Find(ItemID);
+	return Index ? &Items[*Index] : nullptr;
+}
+
+const FWorldItem* UWorldItemRegistry::FindItem(int32 ItemID) const
+{
+	const int32* Index = ItemIndices.Find(ItemID);
+	return Index ? &Items[*Index] : nullptr;
+}
+
+int32 UWorldItemRegistry::AddItem(TSubclassOf<AActor> ItemClass, const FTransform& Transform)
+{
+	if (!*ItemClass)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 Index = Items.AddDefaulted();
+
+	FWorldItem& Item = Items[Index];
+	Item.ItemClass = ItemClass;
+	Item.Location = Transform.GetLocation();
+	Item.Rotation = Transform.Rotator();
+	Item.Cell = GetCell(Item.Location);
+	Item.ItemID = NextItemID++;
+
+	ItemIndices.Add(Item.ItemID, Index);
+	GridCells.FindOrAdd(Item.Cell).Add(Item.ItemID);
+
+	return Item.ItemID;
+}
+
+int32 UWorldItemRegistry::AddItemActor(AActor* ItemActor)
+{
+	if (!ItemActor || ActorItemIDs.Contains(ItemActor))
+	{
+		return INDEX_NONE;
+	}
+
+	ItemActor->DetachRootComponentFromParent();
+	ItemActor->SetOwner(nullptr);
+
+	//Dropped actors may have been spawned outside the pool, the pool takes them over so they can be dematerialized into it
+	UActorPool* ActorPool = AMainGameState::GetWorldActorPool(this);
+
+	if (ActorPool)
+	{
+		ActorPool->AdoptActor(ItemActor);
+	}
+
+	const int32 ItemID = AddItem(ItemActor->GetClass(), ItemActor->GetActorTransform());
+	FWorldItem* Item = FindItem(ItemID);
+
+	if (!Item)
+	{
+		return INDEX_NONE;
+	}
+
+	Item->Actor = ItemActor;
+	Item->LastInRangeUpdate = UpdateNumber;
+	ActorItemIDs.Add(ItemActor, ItemID);
+
+	//Replicate the drop once, then go dormant
+	ItemActor->SetActorTickEnabled(false);
+	ItemActor->SetNetDormancy(DORM_DormantAll);
+	ItemActor->FlushNetDormancy();
+
+	return ItemID;
+}
+
+void UWorldItemRegistry::RemoveItem(int32 ItemID)
+{
+	const int32* IndexPtr = ItemIndices.Find(ItemID);
+
+	if (!IndexPtr)
+	{
+		return;
+	}
+
+	const int32 Index = *IndexPtr;
+
+	TArray<int32>* CellItemIDs = GridCells.Find(Items[Index].Cell);
+
+	if (CellItemIDs)
+	{
+		CellItemIDs->RemoveSwap(ItemID);
+
+		if (CellItemIDs->Num() == 0)
+		{
+			GridCells.Remove(Items[Index].Cell);
+		}
+	}
+
+	if (Items[Index].Actor)
+	{
+		ActorItemIDs.Remove(Items[Index].Actor);
+	}
+
+	ItemIndices.Remove(ItemID);
+	Items.RemoveAtSwap(Index);
+
+	//The last item was moved into the removed slot
+	if (Index < Items.Num())
+	{
+		ItemIndices.Add(Items[Index].ItemID, Index);
+	}
+}
+
+void UWorldItemRegistry::FindItemsInRadius(const FVector& Location, float Radius, TArray<int32>& OutItemIDs) const
+{
+	const FIntPoint MinCell = GetCell(Location - FVector(Radius, Radius, 0));
+	const FIntPoint MaxCell = GetCell(Location + FVector(Radius, Radius, 0));
+	const float RadiusSquared = FMath::Square(Radius);
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			const TArray<int32>* CellItemIDs = GridCells.Find(FIntPoint(X, Y));
+
+			if (!CellItemIDs)
+			{
+				continue;
+			}
+
+			for (int32 ItemID : *CellItemIDs)
+			{
+				const FWorldItem* Item = FindItem(ItemID);
+
+				if (Item && FVector::DistSquared(Item->Location, Location) <= RadiusSquared)
+				{
+					OutItemIDs.Add(ItemID);
+				}
+			}
+		}
+	}
+}
+
+int32 UWorldItemRegistry::FindItemID(const AActor* ItemActor) const
+{
+	const int32* ItemID = ActorItemIDs.Find(const_cast<AActor*>(ItemActor));
+	return ItemID ? *ItemID : INDEX_NONE;
+}
+
+bool UWorldItemRegistry::IsItemInReach(const APawn* Picker, int32 ItemID) const
+{
+	const FWorldItem* Item = FindItem(ItemID);
+
+	return Picker && Item && FVector::DistSquared(Picker->GetActorLocation(), Item->Location) <= FMath::Square(PickUpRadius);
+}
+
+AActor* UWorldItemRegistry::PickUpItem(APawn* Picker, int32 ItemID)
+{
+	if (!IsItemInReach(Picker, ItemID))
+	{
+		return nullptr;
+	}
+
+	FWorldItem* Item = FindItem(ItemID);
+
+	if (!Item->Actor)
+	{
+		MaterializeItem(*Item);
+
+		if (!Item->Actor)
+		{
+			return nullptr;
+		}
+	}
+
+	AActor* ItemActor = Item->Actor;
+	RemoveItem(ItemID);
+
+	//Held items replicate & tick normally
+	ItemActor->SetNetDormancy(DORM_Awake);
+	ItemActor->SetActorTickEnabled(ItemActor->PrimaryActorTick.bCanEverTick);
+
+	return ItemActor;
+}
+
+void UWorldItemRegistry::MaterializeItem(FWorldItem& Item)
+{
+	UActorPool* ActorPool = AMainGameState::GetWorldActorPool(this);
+
+	if (!ActorPool)
+	{
+		return;
+	}
+
+	Item.Actor = ActorPool->AcquireActor(Item.ItemClass, FTransform(Item.Rotation, Item.Location));
+
+	if (!Item.Actor)
+	{
+		return;
+	}
+
+	ActorItemIDs.Add(Item.Actor, Item.ItemID);
+
+	//Items on the ground do not need to tick, the materialized transform is replicated once
+	Item.Actor->SetActorTickEnabled(false);
+	Item.Actor->SetNetDormancy(DORM_DormantAll);
+	Item.Actor->FlushNetDormancy();
+}
+
+void UWorldItemRegistry::DematerializeItem(FWorldItem& Item)
+{
+	UActorPool* ActorPool = AMainGameState::GetWorldActorPool(this);
+
+	if (!Item.Actor)
+	{
+		return;
+	}
+
+	ActorItemIDs.Remove(Item.Actor);
+
+	if (ActorPool)
+	{
+		ActorPool->ReleaseActor(Item.Actor);
+
+		//Replicate the hidden pooled state once
+		Item.Actor->FlushNetDormancy();
+	}
+	else
+	{
+		Item.Actor->Destroy();
+	}
+
+	Item.Actor = nullptr;
+}
+
+/*
+* Materialization update
+* - Only the cells around the player pawns are visited, the cost grows with the items near players instead of every item
+* - Materialized items no player is within DematerializeRadius of anymore give their actor back to the pool
+*/
+void UWorldItemRegistry::UpdateMaterializedItems()
+{
+	UWorld* World = GetWorld();
+
+	if (!World)
+	{
+		return;
+	}
+
+	UpdateNumber++;
+
+	TArray<int32> NearbyItemIDs;
+
+	for (FConstPlayerControllerIterator Iterator = World->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		const APlayerController* PlayerController = *Iterator;
+		const APawn* PlayerPawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+
+		if (!PlayerPawn)
+		{
+			continue;
+		}
+
+		const FVector PlayerLocation = PlayerPawn->GetActorLocation();
+
+		NearbyItemIDs.Reset();
+		FindItemsInRadius(PlayerLocation, DematerializeRadius, NearbyItemIDs);
+
+		for (int32 ItemID : NearbyItemIDs)
+		{
+			FWorldItem* Item = FindItem(ItemID);
+
+			Item->LastInRangeUpdate = UpdateNumber;
+
+			if (!Item->Actor && FVector::DistSquared(Item->Location, PlayerLocation) <= FMath::Square(MaterializeRadius))
+			{
+				MaterializeItem(*Item);
+			}
+		}
+	}
+
+	TArray<int32> OutOfRangeItemIDs;
+
+	for (const auto& ActorItemID : ActorItemIDs)
+	{
+		const FWorldItem* Item = FindItem(ActorItemID.Value);
+
+		if (Item && Item->LastInRangeUpdate != UpdateNumber)
+		{
+			OutOfRangeItemIDs.Add(ActorItemID.Value);
+		}
+	}
+
+	for (int32 ItemID : OutOfRangeItemIDs)
+	{
+		DematerializeItem(*FindItem(ItemID));
+	}
+}
+
+void UWorldItemRegistry::LogRegistryStats() const
+{
+	UE_LOG(LogWesternWar, Log, TEXT("World Items | Items: %d | Materialized: %d | Grid Cells: %d"), Items.Num(), ActorItemIDs.Num(), GridCells.Num());
+}
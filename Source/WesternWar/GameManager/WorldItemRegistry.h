@@ -0,0 +1,104 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#pragma once
+
+#include "Object.h"
+#include "WorldItemRegistry.generated.h"
+
+#define WORLD_ITEM_GRID_CELL_SIZE 1000.0f	//Uniform 2D grid, an item is in the cell of its location
+
+USTRUCT()
+struct FWorldItem
+{
+	//Item lying in the world, only backed by an actor while a player is near it
+
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY()
+		TSubclassOf<AActor> ItemClass;
+	UPROPERTY()
+		AActor* Actor = nullptr;	//Materialized actor, nullptr while the item only exists as this entry
+
+	FVector Location = FVector::ZeroVector;
+	FRotator Rotation = FRotator::ZeroRotator;
+	FIntPoint Cell = FIntPoint::ZeroValue;
+	int32 ItemID = INDEX_NONE;
+	int32 LastInRangeUpdate = 0;	//Last materialization update a player was in range of the item
+};
+
+USTRUCT(BlueprintType)
+struct FWorldItemSpawnData
+{
+	//Item class & where it lies when the map loads
+
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "World Items")
+		TSubclassOf<AActor> ItemClass;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "World Items")
+		FTransform Transform;
+};
+
+/*
+* World Item Registry - every item lying in the world (server only)
+* - Items are plain entries in a spatial grid, proximity queries & pickup validation only look at the cells around the query
+* - Items within MaterializeRadius of a player get an actor from the actor pool, items further than DematerializeRadius
+*   from every player give their actor back, so only the items around players cost an actor
+* - Materialized actors do not tick & are net dormant, they replicate once when materialized or moved & wake when picked up
+*/
+UCLASS()
+class WESTERNWAR_API UWorldItemRegistry : public UObject
+{
+	GENERATED_BODY()
+
+private:
+	UPROPERTY()
+		TArray<FWorldItem> Items;
+
+	TMap<int32, int32> ItemIndices;	//Item ID to index in Items
+	TMap<FIntPoint, TArray<int32>> GridCells;	//Item IDs per cell
+	TMap<AActor*, int32> ActorItemIDs;	//Materialized actor to item ID
+
+	int32 NextItemID = 0;
+	int32 UpdateNumber = 0;
+
+	static FIntPoint GetCell(const FVector& Location);
+
+	FWorldItem* FindItem(int32 ItemID);
+	const FWorldItem* FindItem(int32 ItemID) const;
+
+	void MaterializeItem(FWorldItem& Item);
+	void DematerializeItem(FWorldItem& Item);
+	void RemoveItem(int32 ItemID);
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "World Items")
+		float MaterializeRadius = 4000;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "World Items")
+		float DematerializeRadius = 5000;	//Larger than MaterializeRadius, so items at the edge do not flip every update
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "World Items")
+		float PickUpRadius = 250;
+
+	//Adds an item that only exists as an entry until a player comes near it, returns its ID
+	int32 AddItem(TSubclassOf<AActor> ItemClass, const FTransform& Transform);
+
+	//Adds an existing actor (dropped or thrown item) at its current transform, returns its ID
+	int32 AddItemActor(AActor* ItemActor);
+
+	//Item IDs within the radius of the location
+	void FindItemsInRadius(const FVector& Location, float Radius, TArray<int32>& OutItemIDs) const;
+
+	int32 FindItemID(const AActor* ItemActor) const;
+	bool IsItemInReach(const APawn* Picker, int32 ItemID) const;
+
+	//Validates the picker is in reach, removes the item from the registry & returns its woken actor, nullptr if it can not be picked up
+	AActor* PickUpItem(APawn* Picker, int32 ItemID);
+
+	//Materializes & releases item actors around the player pawns, called on a timer by AMainGameState
+	void UpdateMaterializedItems();
+
+	int32 GetNumItems() const { return Items.Num(); }
+	int32 GetNumMaterializedItems() const { return ActorItemIDs.Num(); }
+
+	void LogRegistryStats() const;
+};
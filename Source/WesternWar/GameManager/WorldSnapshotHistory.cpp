@@ -0,0 +1,178 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#include "WesternWar.h"
+#include "WorldSnapshotHistory.h"
+#include "Player/Character/PlayerCharacter.h"
+
+FWorldSnapshotHistory::FWorldSnapshotHistory()
+{
+	Reset();
+}
+
+void FWorldSnapshotHistory::Reset()
+{
+	for (int32 i = 0; i < WORLD_SNAPSHOT_HISTORY_TICKS; i++)
+	{
+		Ticks[i] = INDEX_NONE;
+		TickTimes[i] = 0;
+		RecordedPawns[i] = 0;
+	}
+
+	NewestTick = INDEX_NONE;
+}
+
+int32 FWorldSnapshotHistory::RegisterPawn(APawn* Pawn)
+{
+	for (int32 Slot = 0; Slot < WORLD_SNAPSHOT_MAX_PAWNS; Slot++)
+	{
+		if (!PawnSlots[Slot].IsValid())
+		{
+			//A pawn destroyed without unregistering leaves its history behind
+			ClearSlotHistory(Slot);
+
+			PawnSlots[Slot] = Pawn;
+			return Slot;
+		}
+	}
+
+	UE_LOG(LogWesternWar, Warning, TEXT("World Snapshot History | No free slot for %s, max %d pawns"), *GetNameSafe(Pawn), WORLD_SNAPSHOT_MAX_PAWNS);
+
+	return INDEX_NONE;
+}
+
+void FWorldSnapshotHistory::UnregisterPawn(int32 Slot)
+{
+	if (Slot >= 0 && Slot < WORLD_SNAPSHOT_MAX_PAWNS)
+	{
+		PawnSlots[Slot] = nullptr;
+		ClearSlotHistory(Slot);
+	}
+}
+
+//The next pawn in the slot must not find the snapshots of the previous one
+void FWorldSnapshotHistory::ClearSlotHistory(int32 Slot)
+{
+	const uint64 SlotMask = ~((uint64)1 << Slot);
+
+	for (int32 i = 0; i < WORLD_SNAPSHOT_HISTORY_TICKS; i++)
+	{
+		RecordedPawns[i] &= SlotMask;
+	}
+}
+
+void FWorldSnapshotHistory::RecordTick(int32 Tick, float ServerTime)
+{
+	//Only allocated once something is recorded, clients never record
+	if (PawnSnapshots.Num() == 0)
+	{
+		PawnSnapshots.SetNumZeroed(WORLD_SNAPSHOT_HISTORY_TICKS * WORLD_SNAPSHOT_MAX_PAWNS);
+	}
+
+	const int32 BlockIndex = GetBlockIndex(Tick);
+	FPawnSnapshot* Block = &PawnSnapshots[BlockIndex * WORLD_SNAPSHOT_MAX_PAWNS];
+
+	uint64 Recorded = 0;
+
+	for (int32 Slot = 0; Slot < WORLD_SNAPSHOT_MAX_PAWNS; Slot++)
+	{
+		const APawn* Pawn = PawnSlots[Slot].Get();
+
+		if (!Pawn)
+		{
+			continue;
+		}
+
+		const APlayerCharacter* PlayerCharacter = Cast<APlayerCharacter>(Pawn);
+
+		FPawnSnapshot& Snapshot = Block[Slot];
+		Snapshot.Location = Pawn->GetActorLocation();
+		Snapshot.Rotation = Pawn->GetActorRotation();
+		Snapshot.SimulationID = PlayerCharacter ? PlayerCharacter->GetLastSimulatedMoveID() : 0;
+
+		Recorded |= (uint64)1 << Slot;
+	}
+
+	Ticks[BlockIndex] = Tick;
+	TickTimes[BlockIndex] = ServerTime;
+	RecordedPawns[BlockIndex] = Recorded;
+	NewestTick = Tick;
+}
+
+bool FWorldSnapshotHistory::HasTick(int32 Tick) const
+{
+	return Tick >= 0 && Ticks[GetBlockIndex(Tick)] == Tick;
+}
+
+int32 FWorldSnapshotHistory::GetOldestTick() const
+{
+	if (NewestTick == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 OldestTick = FMath::Max(NewestTick - WORLD_SNAPSHOT_HISTORY_TICKS + 1, 0);
+
+	return HasTick(OldestTick) ? OldestTick : NewestTick;
+}
+
+float FWorldSnapshotHistory::GetTickTime(int32 Tick) const
+{
+	return HasTick(Tick) ? TickTimes[GetBlockIndex(Tick)] : 0;
+}
+
+int32 FWorldSnapshotHistory::FindTickForTime(float ServerTime) const
+{
+	if (NewestTick == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 OldestTick = GetOldestTick();
+
+	for (int32 Tick = NewestTick; Tick > OldestTick; Tick--)
+	{
+		if (HasTick(Tick) && TickTimes[GetBlockIndex(Tick)] <= ServerTime)
+		{
+			return Tick;
+		}
+	}
+
+	return OldestTick;
+}
+
+const FPawnSnapshot* FWorldSnapshotHistory::GetPawnSnapshot(int32 Tick, int32 Slot) const
+{
+	if (!HasTick(Tick) || Slot < 0 || Slot >= WORLD_SNAPSHOT_MAX_PAWNS)
+	{
+		return nullptr;
+	}
+
+	const int32 BlockIndex = GetBlockIndex(Tick);
+
+	if ((RecordedPawns[BlockIndex] & ((uint64)1 << Slot)) == 0)
+	{
+		return nullptr;
+	}
+
+	return &PawnSnapshots[BlockIndex * WORLD_SNAPSHOT_MAX_PAWNS + Slot];
+}
+
+int32 FWorldSnapshotHistory::FindTickForSimulationID(int32 Slot, int16 SimulationID) const
+{
+	if (NewestTick == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+
+	for (int32 Tick = NewestTick; Tick >= 0 && Tick > NewestTick - WORLD_SNAPSHOT_HISTORY_TICKS; Tick--)
+	{
+		const FPawnSnapshot* Snapshot = GetPawnSnapshot(Tick, Slot);
+
+		if (Snapshot && Snapshot->SimulationID == SimulationID)
+		{
+			return Tick;
+		}
+	}
+
+	return INDEX_NONE;
+}
@@ -0,0 +1,64 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#pragma once
+
+#define WORLD_SNAPSHOT_HISTORY_TICKS 128	//~2 seconds at 60 ticks per second
+#define WORLD_SNAPSHOT_MAX_PAWNS 64
+
+struct FPawnSnapshot
+{
+	FVector Location;
+	FRotator Rotation;
+	int16 SimulationID;	//Last client move the server had simulated for the pawn at this tick
+};
+
+/*
+* World Snapshot History - Ring of the last server ticks, every tick is one contiguous block holding every registered pawns transform
+* - Pawns get a fixed slot when they register, so a pawn at a tick is a single array index
+* - Written once per server tick by AMainGameState, read by lag compensation & replays by server tick
+*/
+class WESTERNWAR_API FWorldSnapshotHistory
+{
+private:
+	TArray<FPawnSnapshot> PawnSnapshots;	//WORLD_SNAPSHOT_HISTORY_TICKS blocks of WORLD_SNAPSHOT_MAX_PAWNS
+	int32 Ticks[WORLD_SNAPSHOT_HISTORY_TICKS];
+	float TickTimes[WORLD_SNAPSHOT_HISTORY_TICKS];
+	uint64 RecordedPawns[WORLD_SNAPSHOT_HISTORY_TICKS];	//Bit per slot that has a snapshot at the tick
+
+	TWeakObjectPtr<APawn> PawnSlots[WORLD_SNAPSHOT_MAX_PAWNS];
+
+	int32 NewestTick = INDEX_NONE;
+
+	static int32 GetBlockIndex(int32 Tick) { return Tick % WORLD_SNAPSHOT_HISTORY_TICKS; }
+
+	void ClearSlotHistory(int32 Slot);
+
+public:
+	FWorldSnapshotHistory();
+
+	//Returns the slot of the pawn, INDEX_NONE if every slot is taken
+	int32 RegisterPawn(APawn* Pawn);
+	//Frees the slot & drops its snapshots from every stored tick
+	void UnregisterPawn(int32 Slot);
+
+	//Records the transform of every registered pawn into the block of the tick
+	void RecordTick(int32 Tick, float ServerTime);
+
+	bool HasTick(int32 Tick) const;
+	int32 GetNewestTick() const { return NewestTick; }
+	int32 GetOldestTick() const;
+	float GetTickTime(int32 Tick) const;
+
+	//Newest tick recorded at or before the server time, the oldest tick if the time is older than the history
+	int32 FindTickForTime(float ServerTime) const;
+
+	APawn* GetPawn(int32 Slot) const { return Slot >= 0 && Slot < WORLD_SNAPSHOT_MAX_PAWNS ? PawnSlots[Slot].Get() : nullptr; }
+
+	//nullptr if the tick is no longer in the history or the pawn was not registered at the time
+	const FPawnSnapshot* GetPawnSnapshot(int32 Tick, int32 Slot) const;
+
+	//Newest tick at which the server had simulated the given move of the pawn, INDEX_NONE if it is not in the history
+	int32 FindTickForSimulationID(int32 Slot, int16 SimulationID) const;
+
+	void Reset();
+};
@@ -0,0 +1,9 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#include "WesternWar.h"
+#include "PooledActorInterface.h"
+
+UPooledActorInterface::UPooledActorInterface(const class FObjectInitializer& ObjectInitializer) :Super(ObjectInitializer)
+{
+
+}
@@ -0,0 +1,29 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#pragma once
+
+#include "PooledActorInterface.generated.h"
+
+UINTERFACE(BlueprintType)
+class UPooledActorInterface : public UInterface
+{
+	GENERATED_UINTERFACE_BODY()
+};
+
+/*
+* Implemented by actors that are handed out by the actor pool
+* - OnAcquiredFromPool is called right after the actor is activated and placed in the world
+* - OnReturnedToPool is called right before the actor is hidden and put back into the pool,
+*   the actor should reset any gameplay state here so it can be reused
+*/
+class IPooledActorInterface
+{
+
+	GENERATED_IINTERFACE_BODY()
+
+public:
+	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category = "Actor Pool")
+		void OnAcquiredFromPool();
+	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category = "Actor Pool")
+		void OnReturnedToPool();
+};
@@ -0,0 +1,550 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#include "WesternWar.h"
+#include "KillcamHistory.h"
+#include "GameManager/MainGameState.h"
+
+static TAutoConsoleVariable<float> CVarKillcamSeconds(
+	TEXT("ww.Killcam.Seconds"),
+	10,
+	TEXT("Seconds of pawn state & fire events the server keeps for killcams"));
+
+static TAutoConsoleVariable<int32> CVarKillcamMaxKB(
+	TEXT("ww.Killcam.MaxKB"),
+	1024,
+	TEXT("Memory cap of the killcam history in KB, the oldest seconds are dropped first"));
+
+static void RunKillcamStats(UWorld* World)
+{
+	AMainGameState* MainGameState = World ? Cast<AMainGameState>(World->GetGameState()) : nullptr;
+
+	if (MainGameState)
+	{
+		MainGameState->GetKillcamHistory().LogStats();
+	}
+}
+
+static FAutoConsoleCommandWithWorld KillcamStatsCommand(
+	TEXT("ww.Killcam.Stats"),
+	TEXT("Log the size & recorded bytes per second of the killcam history"),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&RunKillcamStats));
+
+/*
+* -- Byte stream helpers - LEB128 varints, signed values are zigzag encoded --
+*/
+
+static void WriteVarUInt(TArray<uint8>& Data, uint64 Value)
+{
+	do
+	{
+		uint8 Byte = Value & 0x7F;
+		Value >>= 7;
+		Data.Add(Value ? (Byte | 0x80) : Byte);
+	}
+	while (Value);
+}
+
+static void WriteVarInt(TArray<uint8>& Data, int64 Value)
+{
+	WriteVarUInt(Data, ((uint64)Value << 1) ^ (uint64)(Value >> 63));
+}
+
+static void WriteUInt16(TArray<uint8>& Data, uint16 Value)
+{
+	Data.Add(Value & 0xFF);
+	Data.Add(Value >> 8);
+}
+
+struct FKillcamReader
+{
+	const uint8* Cursor;
+	const uint8* End;
+	bool bIsError = false;
+
+	FKillcamReader(const uint8* InData, int32 Num) : Cursor(InData), End(InData + Num) {}
+
+	bool AtEnd() const { return Cursor >= End; }
+
+	uint8 ReadByte()
+	{
+		if (Cursor >= End)
+		{
+			bIsError = true;
+			return 0;
+		}
+
+		return *Cursor++;
+	}
+
+	uint64 ReadVarUInt()
+	{
+		uint64 Value = 0;
+
+		for (int32 Shift = 0; Shift < 64 && !bIsError; Shift += 7)
+		{
+			const uint8 Byte = ReadByte();
+			Value |= (uint64)(Byte & 0x7F) << Shift;
+
+			if (!(Byte & 0x80))
+			{
+				break;
+			}
+		}
+
+		return Value;
+	}
+
+	int64 ReadVarInt()
+	{
+		const uint64 Value = ReadVarUInt();
+		return (int64)(Value >> 1) ^ -(int64)(Value & 1);
+	}
+
+	uint16 ReadUInt16()
+	{
+		const uint16 Low = ReadByte();
+		return Low | ((uint16)ReadByte() << 8);
+	}
+};
+
+static FORCEINLINE uint16 QuantizeAngle(float Angle)
+{
+	return (uint16)(FMath::RoundToInt(FRotator::ClampAxis(Angle) * 65536.0f / 360.0f) & 0xFFFF);
+}
+
+static FORCEINLINE float DequantizeAngle(uint16 Angle)
+{
+	return FRotator::NormalizeAxis(Angle * 360.0f / 65536.0f);
+}
+
+FKillcamHistory::FKillcamHistory()
+{
+	Reset();
+}
+
+void FKillcamHistory::Reset()
+{
+	Segments.Empty();
+	PendingFireEvents.Empty();
+	SlotPawns.Empty();
+
+	for (int32 Slot = 0; Slot < WORLD_SNAPSHOT_MAX_PAWNS; Slot++)
+	{
+		CurrentSlotPawns[Slot] = nullptr;
+	}
+
+	NextFrameTime = 0;
+
+	PreviousSlotMask = 0;
+	PreviousTick = 0;
+	PreviousTimeMs = 0;
+
+	TotalBytesRecorded = 0;
+	FirstRecordedTime = -1;
+	LastRecordedTime = 0;
+	PeakMemoryBytes = 0;
+}
+
+void FKillcamHistory::RecordFireEvent(int32 Slot, const FVector& Origin, const FVector& Direction)
+{
+	if (Slot < 0 || Slot >= WORLD_SNAPSHOT_MAX_PAWNS)
+	{
+		return;
+	}
+
+	FKillcamFireEvent FireEvent;
+	FireEvent.Slot = Slot;
+	FireEvent.Origin = Origin;
+	FireEvent.Direction = Direction;
+
+	PendingFireEvents.Add(FireEvent);
+}
+
+/*
+* Frame layout
+* - Flags (1 - keyframe), tick & time in ms (keyframe - full, otherwise the difference to the previous frame)
+* - Slot mask (keyframe - full, otherwise XOR with the previous mask, 1 byte while nobody joins or leaves)
+* - Per pawn: location & yaw, full for keyframes & pawns that were not in the previous frame, otherwise the difference
+* - Fire events: slot, origin relative to the shooter, yaw & pitch of the direction
+*/
+void FKillcamHistory::RecordTick(int32 Tick, float ServerTime, const FWorldSnapshotHistory& SnapshotHistory)
+{
+	if (ServerTime < NextFrameTime)
+	{
+		return;
+	}
+
+	//Stays on the interval grid, a long hitch restarts it instead of recording a burst of frames
+	NextFrameTime += KILLCAM_FRAME_INTERVAL;
+
+	if (NextFrameTime <= ServerTime)
+	{
+		NextFrameTime = ServerTime + KILLCAM_FRAME_INTERVAL;
+	}
+
+	const bool bIsKeyframe = Segments.Num() == 0 || Segments.Last().NumFrames >= KILLCAM_KEYFRAME_INTERVAL;
+
+	if (bIsKeyframe)
+	{
+		FKillcamSegment& NewSegment = Segments[Segments.AddDefaulted()];
+		NewSegment.StartTime = ServerTime;
+	}
+
+	FKillcamSegment& Segment = Segments.Last();
+	TArray<uint8>& Data = Segment.Data;
+	const int32 StartNum = Data.Num();
+
+	const int64 TimeMs = FMath::RoundToInt(ServerTime * 1000);
+
+	uint64 SlotMask = 0;
+	int32 Locations[WORLD_SNAPSHOT_MAX_PAWNS][3];
+	uint16 Yaws[WORLD_SNAPSHOT_MAX_PAWNS];
+
+	for (int32 Slot = 0; Slot < WORLD_SNAPSHOT_MAX_PAWNS; Slot++)
+	{
+		const FPawnSnapshot* Snapshot = SnapshotHistory.GetPawnSnapshot(Tick, Slot);
+
+		if (Snapshot)
+		{
+			SlotMask |= (uint64)1 << Slot;
+			Locations[Slot][0] = FMath::RoundToInt(Snapshot->Location.X);
+			Locations[Slot][1] = FMath::RoundToInt(Snapshot->Location.Y);
+			Locations[Slot][2] = FMath::RoundToInt(Snapshot->Location.Z);
+			Yaws[Slot] = QuantizeAngle(Snapshot->Rotation.Yaw);
+
+			APawn* Pawn = SnapshotHistory.GetPawn(Slot);
+
+			if (CurrentSlotPawns[Slot].Get() != Pawn)
+			{
+				CurrentSlotPawns[Slot] = Pawn;
+
+				FKillcamSlotPawn& SlotPawn = SlotPawns[SlotPawns.AddDefaulted()];
+				SlotPawn.Slot = Slot;
+				SlotPawn.Pawn = Pawn;
+				SlotPawn.StartTimeMs = TimeMs;
+			}
+		}
+	}
+
+	Data.Add(bIsKeyframe ? 1 : 0);
+	WriteVarUInt(Data, bIsKeyframe ? Tick : Tick - PreviousTick);
+	WriteVarUInt(Data, bIsKeyframe ? TimeMs : TimeMs - PreviousTimeMs);
+	WriteVarUInt(Data, bIsKeyframe ? SlotMask : SlotMask ^ PreviousSlotMask);
+
+	for (int32 Slot = 0; Slot < WORLD_SNAPSHOT_MAX_PAWNS; Slot++)
+	{
+		const uint64 SlotBit = (uint64)1 << Slot;
+
+		if (!(SlotMask & SlotBit))
+		{
+			continue;
+		}
+
+		if (bIsKeyframe || !(PreviousSlotMask & SlotBit))
+		{
+			WriteVarInt(Data, Locations[Slot][0]);
+			WriteVarInt(Data, Locations[Slot][1]);
+			WriteVarInt(Data, Locations[Slot][2]);
+			WriteUInt16(Data, Yaws[Slot]);
+		}
+		else
+		{
+			WriteVarInt(Data, Locations[Slot][0] - PreviousLocations[Slot][0]);
+			WriteVarInt(Data, Locations[Slot][1] - PreviousLocations[Slot][1]);
+			WriteVarInt(Data, Locations[Slot][2] - PreviousLocations[Slot][2]);
+			WriteVarInt(Data, (int16)(Yaws[Slot] - PreviousYaws[Slot]));
+		}
+
+		PreviousLocations[Slot][0] = Locations[Slot][0];
+		PreviousLocations[Slot][1] = Locations[Slot][1];
+		PreviousLocations[Slot][2] = Locations[Slot][2];
+		PreviousYaws[Slot] = Yaws[Slot];
+	}
+
+	WriteVarUInt(Data, PendingFireEvents.Num());
+
+	for (const FKillcamFireEvent& FireEvent : PendingFireEvents)
+	{
+		const bool bHasShooter = (SlotMask & ((uint64)1 << FireEvent.Slot)) != 0;
+		const FRotator Direction = FireEvent.Direction.Rotation();
+
+		Data.Add((uint8)FireEvent.Slot);
+		WriteVarInt(Data, FMath::RoundToInt(FireEvent.Origin.X) - (bHasShooter ? Locations[FireEvent.Slot][0] : 0));
+		WriteVarInt(Data, FMath::RoundToInt(FireEvent.Origin.Y) - (bHasShooter ? Locations[FireEvent.Slot][1] : 0));
+		WriteVarInt(Data, FMath::RoundToInt(FireEvent.Origin.Z) - (bHasShooter ? Locations[FireEvent.Slot][2] : 0));
+		WriteUInt16(Data, QuantizeAngle(Direction.Yaw));
+		WriteUInt16(Data, QuantizeAngle(Direction.Pitch));
+	}
+
+	PendingFireEvents.Reset();
+
+	PreviousSlotMask = SlotMask;
+	PreviousTick = Tick;
+	PreviousTimeMs = TimeMs;
+
+	Segment.EndTime = ServerTime;
+	Segment.NumFrames++;
+
+	TotalBytesRecorded += Data.Num() - StartNum;
+
+	if (FirstRecordedTime < 0)
+	{
+		FirstRecordedTime = ServerTime;
+	}
+	LastRecordedTime = ServerTime;
+
+	EnforceLimits();
+}
+
+//Drops whole segments from the front, the newest segment is always kept
+void FKillcamHistory::EnforceLimits()
+{
+	const float MaxSeconds = FMath::Max(CVarKillcamSeconds.GetValueOnGameThread(), 1.0f);
+	const int32 MaxBytes = FMath::Max(CVarKillcamMaxKB.GetValueOnGameThread(), 16) * 1024;
+
+	int32 NumToDrop = 0;
+	int32 MemoryBytes = GetMemoryBytes();
+
+	while (NumToDrop < Segments.Num() - 1
+		&& (Segments.Last().EndTime - Segments[NumToDrop + 1].StartTime > MaxSeconds || MemoryBytes > MaxBytes))
+	{
+		MemoryBytes -= Segments[NumToDrop].Data.GetAllocatedSize();
+		NumToDrop++;
+	}
+
+	if (NumToDrop > 0)
+	{
+		Segments.RemoveAt(0, NumToDrop, false);
+
+		//A pawn replaced in its slot before the oldest frame can no longer be in a clip
+		const int64 OldestTimeMs = FMath::RoundToInt(Segments[0].StartTime * 1000);
+		bool bIsSlotReplaced[WORLD_SNAPSHOT_MAX_PAWNS] = { false };
+
+		for (int32 i = SlotPawns.Num() - 1; i >= 0; i--)
+		{
+			const int32 Slot = SlotPawns[i].Slot;
+
+			if (bIsSlotReplaced[Slot])
+			{
+				SlotPawns.RemoveAt(i, 1, false);
+			}
+			else if (SlotPawns[i].StartTimeMs <= OldestTimeMs)
+			{
+				bIsSlotReplaced[Slot] = true;
+			}
+		}
+
+		MemoryBytes = GetMemoryBytes();
+	}
+
+	PeakMemoryBytes = FMath::Max(PeakMemoryBytes, MemoryBytes);
+}
+
+/*
+* Clip - version, the slot pawn table & the segments covering the last seconds
+* - Every segment starts with a keyframe so the clip decodes on its own
+* - The table holds the slot & start time of every pawn in the clip, the pawns themselves are sent in the same order next to it
+*/
+bool FKillcamHistory::ExtractClip(float Seconds, TArray<uint8>& OutClip, TArray<APawn*>& OutPawns) const
+{
+	OutClip.Reset();
+	OutPawns.Reset();
+
+	if (Segments.Num() == 0)
+	{
+		return false;
+	}
+
+	const float FromTime = Segments.Last().EndTime - Seconds;
+
+	int32 FirstSegment = Segments.Num() - 1;
+
+	while (FirstSegment > 0 && Segments[FirstSegment].StartTime > FromTime)
+	{
+		FirstSegment--;
+	}
+
+	OutClip.Add(KILLCAM_CLIP_VERSION);
+
+	//Pawns still in their slot at the start of the clip or taking one later, collected newest first
+	const int64 ClipStartTimeMs = FMath::RoundToInt(Segments[FirstSegment].StartTime * 1000);
+	bool bIsSlotReplaced[WORLD_SNAPSHOT_MAX_PAWNS] = { false };
+	TArray<const FKillcamSlotPawn*> ClipSlotPawns;
+
+	for (int32 i = SlotPawns.Num() - 1; i >= 0; i--)
+	{
+		const FKillcamSlotPawn& SlotPawn = SlotPawns[i];
+
+		if (!bIsSlotReplaced[SlotPawn.Slot])
+		{
+			ClipSlotPawns.Add(&SlotPawn);
+			bIsSlotReplaced[SlotPawn.Slot] = SlotPawn.StartTimeMs <= ClipStartTimeMs;
+		}
+	}
+
+	WriteVarUInt(OutClip, ClipSlotPawns.Num());
+
+	for (int32 i = ClipSlotPawns.Num() - 1; i >= 0; i--)
+	{
+		OutClip.Add((uint8)ClipSlotPawns[i]->Slot);
+		WriteVarUInt(OutClip, ClipSlotPawns[i]->StartTimeMs);
+		OutPawns.Add(ClipSlotPawns[i]->Pawn.Get());
+	}
+
+	for (int32 i = FirstSegment; i < Segments.Num(); i++)
+	{
+		OutClip.Append(Segments[i].Data);
+	}
+
+	return true;
+}
+
+bool FKillcamHistory::DecodeClip(const TArray<uint8>& Clip, TArray<FKillcamFrame>& OutFrames)
+{
+	OutFrames.Reset();
+
+	FKillcamReader Reader(Clip.GetData(), Clip.Num());
+
+	if (Reader.ReadByte() != KILLCAM_CLIP_VERSION)
+	{
+		return false;
+	}
+
+	//Slot pawn table, applied to the slots as the frames reach the start time of each pawn
+	const int32 NumPawns = (int32)FMath::Min(Reader.ReadVarUInt(), (uint64)Clip.Num());
+	TArray<int32> PawnSlots;
+	TArray<int64> PawnStartTimesMs;
+
+	for (int32 i = 0; i < NumPawns && !Reader.bIsError; i++)
+	{
+		PawnSlots.Add(FMath::Min((int32)Reader.ReadByte(), WORLD_SNAPSHOT_MAX_PAWNS - 1));
+		PawnStartTimesMs.Add((int64)Reader.ReadVarUInt());
+	}
+
+	if (Reader.bIsError)
+	{
+		return false;
+	}
+
+	int32 SlotPawnIndices[WORLD_SNAPSHOT_MAX_PAWNS];
+	int32 NextPawn = 0;
+
+	for (int32 Slot = 0; Slot < WORLD_SNAPSHOT_MAX_PAWNS; Slot++)
+	{
+		SlotPawnIndices[Slot] = INDEX_NONE;
+	}
+
+	uint64 SlotMask = 0;
+	int64 Tick = 0;
+	int64 TimeMs = 0;
+	int32 Locations[WORLD_SNAPSHOT_MAX_PAWNS][3];
+	uint16 Yaws[WORLD_SNAPSHOT_MAX_PAWNS];
+
+	while (!Reader.AtEnd() && !Reader.bIsError)
+	{
+		const bool bIsKeyframe = (Reader.ReadByte() & 1) != 0;
+
+		const uint64 PreviousSlotMask = SlotMask;
+
+		Tick = bIsKeyframe ? Reader.ReadVarUInt() : Tick + Reader.ReadVarUInt();
+		TimeMs = bIsKeyframe ? Reader.ReadVarUInt() : TimeMs + Reader.ReadVarUInt();
+		SlotMask = bIsKeyframe ? Reader.ReadVarUInt() : SlotMask ^ Reader.ReadVarUInt();
+
+		FKillcamFrame& Frame = OutFrames[OutFrames.AddDefaulted()];
+		Frame.Tick = (int32)Tick;
+		Frame.ServerTime = TimeMs / 1000.0f;
+
+		for (; NextPawn < PawnSlots.Num() && PawnStartTimesMs[NextPawn] <= TimeMs; NextPawn++)
+		{
+			SlotPawnIndices[PawnSlots[NextPawn]] = NextPawn;
+		}
+
+		for (int32 Slot = 0; Slot < WORLD_SNAPSHOT_MAX_PAWNS; Slot++)
+		{
+			const uint64 SlotBit = (uint64)1 << Slot;
+
+			if (!(SlotMask & SlotBit))
+			{
+				continue;
+			}
+
+			if (bIsKeyframe || !(PreviousSlotMask & SlotBit))
+			{
+				Locations[Slot][0] = (int32)Reader.ReadVarInt();
+				Locations[Slot][1] = (int32)Reader.ReadVarInt();
+				Locations[Slot][2] = (int32)Reader.ReadVarInt();
+				Yaws[Slot] = Reader.ReadUInt16();
+			}
+			else
+			{
+				Locations[Slot][0] += (int32)Reader.ReadVarInt();
+				Locations[Slot][1] += (int32)Reader.ReadVarInt();
+				Locations[Slot][2] += (int32)Reader.ReadVarInt();
+				Yaws[Slot] = (uint16)(Yaws[Slot] + (int16)Reader.ReadVarInt());
+			}
+
+			FKillcamPawnState& PawnState = Frame.Pawns[Frame.Pawns.AddDefaulted()];
+			PawnState.Slot = Slot;
+			PawnState.PawnIndex = SlotPawnIndices[Slot];
+			PawnState.Location = FVector(Locations[Slot][0], Locations[Slot][1], Locations[Slot][2]);
+			PawnState.Yaw = DequantizeAngle(Yaws[Slot]);
+		}
+
+		const int32 NumFireEvents = (int32)Reader.ReadVarUInt();
+
+		for (int32 i = 0; i < NumFireEvents && !Reader.bIsError; i++)
+		{
+			FKillcamFireEvent& FireEvent = Frame.FireEvents[Frame.FireEvents.AddDefaulted()];
+			FireEvent.Slot = FMath::Min((int32)Reader.ReadByte(), WORLD_SNAPSHOT_MAX_PAWNS - 1);
+
+			const bool bHasShooter = (SlotMask & ((uint64)1 << FireEvent.Slot)) != 0;
+			FireEvent.PawnIndex = bHasShooter ? SlotPawnIndices[FireEvent.Slot] : INDEX_NONE;
+
+			FireEvent.Origin.X = (int32)Reader.ReadVarInt() + (bHasShooter ? Locations[FireEvent.Slot][0] : 0);
+			FireEvent.Origin.Y = (int32)Reader.ReadVarInt() + (bHasShooter ? Locations[FireEvent.Slot][1] : 0);
+			FireEvent.Origin.Z = (int32)Reader.ReadVarInt() + (bHasShooter ? Locations[FireEvent.Slot][2] : 0);
+
+			const float DirectionYaw = DequantizeAngle(Reader.ReadUInt16());
+			const float DirectionPitch = DequantizeAngle(Reader.ReadUInt16());
+			FireEvent.Direction = FRotator(DirectionPitch, DirectionYaw, 0).Vector();
+		}
+	}
+
+	//A truncated last frame is dropped, the frames before it are still valid
+	if (Reader.bIsError && OutFrames.Num() > 0)
+	{
+		OutFrames.Pop();
+	}
+
+	return OutFrames.Num() > 0;
+}
+
+int32 FKillcamHistory::GetMemoryBytes() const
+{
+	int32 MemoryBytes = Segments.GetAllocatedSize() + SlotPawns.GetAllocatedSize();
+
+	for (const FKillcamSegment& Segment : Segments)
+	{
+		MemoryBytes += Segment.Data.GetAllocatedSize();
+	}
+
+	return MemoryBytes;
+}
+
+float FKillcamHistory::GetBytesPerSecond() const
+{
+	const float RecordedSeconds = LastRecordedTime - FirstRecordedTime;
+
+	return FirstRecordedTime >= 0 && RecordedSeconds > 0 ? TotalBytesRecorded / RecordedSeconds : 0;
+}
+
+float FKillcamHistory::GetHistorySeconds() const
+{
+	return Segments.Num() > 0 ? Segments.Last().EndTime - Segments[0].StartTime : 0;
+}
+
+void FKillcamHistory::LogStats() const
+{
+	UE_LOG(LogWesternWar, Log, TEXT("Killcam History | %.1f s in %d segments | Memory: %.1f KB (Peak %.1f KB) | Recorded: %.1f KB/s"),
+		GetHistorySeconds(), Segments.Num(), GetMemoryBytes() / 1024.0f, PeakMemoryBytes / 1024.0f, GetBytesPerSecond() / 1024.0f);
+}
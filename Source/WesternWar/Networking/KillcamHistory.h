@@ -0,0 +1,104 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#pragma once
+
+#include "GameManager/WorldSnapshotHistory.h"
+
+#define KILLCAM_FRAME_INTERVAL 0.05f	//Seconds of server time between frames, 20 frames per second at any tick rate
+#define KILLCAM_KEYFRAME_INTERVAL 20	//Frames per segment, every segment starts with a full state keyframe
+#define KILLCAM_CLIP_VERSION 2
+#define KILLCAM_CLIP_CHUNK_SIZE 1024	//Bytes per reliable RPC when a clip is streamed to a client
+
+struct FKillcamPawnState
+{
+	int32 Slot;	//World snapshot slot
+	int32 PawnIndex;	//Pawn in the slot at the time of the frame, index into the pawns sent with the clip
+	FVector Location;
+	float Yaw;
+};
+
+struct FKillcamFireEvent
+{
+	int32 Slot;
+	int32 PawnIndex;	//INDEX_NONE if the slot had no pawn at the time
+	FVector Origin;
+	FVector Direction;
+};
+
+//A pawn taking a world snapshot slot, the slot is its own until the next pawn takes it
+struct FKillcamSlotPawn
+{
+	int32 Slot;
+	TWeakObjectPtr<APawn> Pawn;
+	int64 StartTimeMs;	//Time of the first frame with the pawn, same rounding as the frame times
+};
+
+struct FKillcamFrame
+{
+	int32 Tick;
+	float ServerTime;
+	TArray<FKillcamPawnState> Pawns;
+	TArray<FKillcamFireEvent> FireEvents;
+};
+
+//Frames of one keyframe interval, the oldest segment is dropped as a whole
+struct FKillcamSegment
+{
+	TArray<uint8> Data;
+	float StartTime = 0;
+	float EndTime = 0;
+	int32 NumFrames = 0;
+};
+
+/*
+* Killcam History - delta compressed ring of every pawns state & fire events for the last seconds (server only)
+* - Locations are quantized to 1 unit & yaw to 16 bits, frames store the varint difference to the previous frame,
+*   so a standing pawn costs 4 bytes per frame & a running one ~8
+* - Capped by ww.Killcam.Seconds & ww.Killcam.MaxKB, the bytes per second recorded are measured (ww.Killcam.Stats)
+* - ExtractClip copies the segments of the last seconds as they are, a clip is decoded by the killed players client
+* - The pawn in every slot is recorded with the frame it appeared in, so a slot reused during the clip maps to both pawns
+*/
+class WESTERNWAR_API FKillcamHistory
+{
+private:
+	TArray<FKillcamSegment> Segments;	//Oldest first
+	TArray<FKillcamFireEvent> PendingFireEvents;
+	TArray<FKillcamSlotPawn> SlotPawns;	//Oldest first, pawns replaced before the oldest segment are dropped
+	TWeakObjectPtr<APawn> CurrentSlotPawns[WORLD_SNAPSHOT_MAX_PAWNS];
+
+	float NextFrameTime = 0;
+
+	//Encoder state - previous frame of the current segment
+	uint64 PreviousSlotMask = 0;
+	int32 PreviousTick = 0;
+	int64 PreviousTimeMs = 0;
+	int32 PreviousLocations[WORLD_SNAPSHOT_MAX_PAWNS][3];
+	uint16 PreviousYaws[WORLD_SNAPSHOT_MAX_PAWNS];
+
+	int64 TotalBytesRecorded = 0;
+	float FirstRecordedTime = -1;
+	float LastRecordedTime = 0;
+	int32 PeakMemoryBytes = 0;
+
+	void EnforceLimits();
+
+public:
+	FKillcamHistory();
+
+	//Records the tick as a frame once KILLCAM_FRAME_INTERVAL has passed, called once per server tick after the world snapshot is recorded
+	void RecordTick(int32 Tick, float ServerTime, const FWorldSnapshotHistory& SnapshotHistory);
+
+	//Written with the next recorded frame
+	void RecordFireEvent(int32 Slot, const FVector& Origin, const FVector& Direction);
+
+	//Compact clip of the last seconds of history & the pawns that held its slots, false if there is no history yet
+	bool ExtractClip(float Seconds, TArray<uint8>& OutClip, TArray<APawn*>& OutPawns) const;
+	static bool DecodeClip(const TArray<uint8>& Clip, TArray<FKillcamFrame>& OutFrames);
+
+	int32 GetMemoryBytes() const;
+	float GetBytesPerSecond() const;
+	float GetHistorySeconds() const;
+
+	void LogStats() const;
+	void Reset();
+};
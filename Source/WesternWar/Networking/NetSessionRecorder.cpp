@@ -0,0 +1,243 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#include "WesternWar.h"
+#include "NetSessionRecorder.h"
+#include "Player/Character/PlayerCharacter.h"
+
+#define NET_RECORDING_FLUSH_SIZE 65536
+
+static TAutoConsoleVariable<int32> CVarNetRecord(
+	TEXT("ww.NetRecord"),
+	0,
+	TEXT("Record every move & server snapshot of player characters to Saved/NetRecordings. 0 - Off, 1 - On (read when a character spawns)"));
+
+/*
+* Offline re-simulation - ww.NetReplay <File>
+* Open the map the recording was made on in standalone & run the command, the local player character re-simulates
+* every recorded move & logs how many results differ from the recording & how long the simulation took
+*/
+static void RunNetReplay(const TArray<FString>& Args, UWorld* World)
+{
+	if (Args.Num() < 1 || !World)
+	{
+		UE_LOG(LogWesternWar, Warning, TEXT("Usage: ww.NetReplay <File>"));
+		return;
+	}
+
+	FString FilePath = Args[0];
+
+	if (FPaths::IsRelative(FilePath))
+	{
+		FilePath = FPaths::GameSavedDir() / TEXT("NetRecordings") / FilePath;
+	}
+
+	FNetSessionRecording Recording;
+
+	if (!Recording.Load(FilePath))
+	{
+		UE_LOG(LogWesternWar, Warning, TEXT("Net Replay | Failed to load %s"), *FilePath);
+		return;
+	}
+
+	APlayerCharacter* PlayerCharacter = Cast<APlayerCharacter>(UGameplayStatics::GetPlayerPawn(World, 0));
+
+	if (!PlayerCharacter)
+	{
+		UE_LOG(LogWesternWar, Warning, TEXT("Net Replay | No local player character to re-simulate with"));
+		return;
+	}
+
+	PlayerCharacter->ResimulateRecording(Recording);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs NetReplayCommand(
+	TEXT("ww.NetReplay"),
+	TEXT("Re-simulate a net recording with the local player character. Usage: ww.NetReplay <File>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunNetReplay));
+
+FNetSessionRecorder::~FNetSessionRecorder()
+{
+	StopRecording();
+}
+
+bool FNetSessionRecorder::StartRecording(const FString& FilePath)
+{
+	StopRecording();
+
+	FileWriter = IFileManager::Get().CreateFileWriter(*FilePath);
+
+	if (!FileWriter)
+	{
+		UE_LOG(LogWesternWar, Warning, TEXT("Net Recording | Failed to create %s"), *FilePath);
+		return false;
+	}
+
+	Buffer.Reserve(NET_RECORDING_FLUSH_SIZE * 2);
+
+	uint32 Magic = NET_RECORDING_MAGIC;
+	uint16 Version = NET_RECORDING_VERSION;
+
+	FMemoryWriter Ar(Buffer);
+	Ar << Magic;
+	Ar << Version;
+
+	UE_LOG(LogWesternWar, Log, TEXT("Net Recording | Recording to %s"), *FilePath);
+
+	return true;
+}
+
+void FNetSessionRecorder::StopRecording()
+{
+	if (FileWriter)
+	{
+		Flush();
+		FileWriter->Close();
+
+		delete FileWriter;
+		FileWriter = nullptr;
+	}
+}
+
+void FNetSessionRecorder::Flush()
+{
+	if (FileWriter && Buffer.Num() > 0)
+	{
+		FileWriter->Serialize(Buffer.GetData(), Buffer.Num());
+		Buffer.Reset();
+	}
+}
+
+void FNetSessionRecorder::RecordClientMove(const FClientCharacterData& Move, float Time)
+{
+	if (!FileWriter)
+	{
+		return;
+	}
+
+	uint8 Type = ENetRecordType::ClientMove;
+	FClientCharacterData MoveCopy = Move;
+
+	FMemoryWriter Ar(Buffer);
+	Ar.Seek(Buffer.Num());
+	Ar << Type;
+	Ar << Time;
+	SerializeClientMove(Ar, MoveCopy);
+
+	if (Buffer.Num() >= NET_RECORDING_FLUSH_SIZE)
+	{
+		Flush();
+	}
+}
+
+void FNetSessionRecorder::RecordServerSnapshot(const FServerCharacterData& Snapshot, float Time)
+{
+	if (!FileWriter)
+	{
+		return;
+	}
+
+	uint8 Type = ENetRecordType::ServerSnapshot;
+	FServerCharacterData SnapshotCopy = Snapshot;
+
+	FMemoryWriter Ar(Buffer);
+	Ar.Seek(Buffer.Num());
+	Ar << Type;
+	Ar << Time;
+	SerializeServerSnapshot(Ar, SnapshotCopy);
+
+	if (Buffer.Num() >= NET_RECORDING_FLUSH_SIZE)
+	{
+		Flush();
+	}
+}
+
+bool FNetSessionRecorder::IsRecordingEnabled()
+{
+	return CVarNetRecord.GetValueOnGameThread() != 0;
+}
+
+FString FNetSessionRecorder::GetRecordingPath(const AActor* RecordedActor)
+{
+	const TCHAR* NetMode = RecordedActor && RecordedActor->GetNetMode() == NM_Client ? TEXT("Client") : TEXT("Server");
+
+	return FPaths::GameSavedDir() / TEXT("NetRecordings") / FString::Printf(TEXT("%s-%s-%s.wwrec"), *GetNameSafe(RecordedActor), NetMode, *FDateTime::Now().ToString());
+}
+
+void FNetSessionRecorder::SerializeClientMove(FArchive& Ar, FClientCharacterData& Move)
+{
+	Ar << Move.SimulationID;
+	Ar << Move.DeltaTime;
+	Ar << Move.VerticalInput;
+	Ar << Move.HorizontalInput;
+	Ar << Move.UpInput;
+	Ar << Move.VerticalLookInput;
+	Ar << Move.HorizontalLookInput;
+	Ar << Move.Location;
+	Ar << Move.Rotation;
+}
+
+void FNetSessionRecorder::SerializeServerSnapshot(FArchive& Ar, FServerCharacterData& Snapshot)
+{
+	Ar << Snapshot.SimulationID;
+	Ar << Snapshot.Location;
+	Ar << Snapshot.Rotation;
+	Ar << Snapshot.MovementState.MoveDirection;
+	Ar << Snapshot.MovementState.HorizontalTurnVal;
+	Ar << Snapshot.MovementState.JumpTimer;
+	Ar << Snapshot.MovementState.bCanJump;
+	Ar << Snapshot.ServerTime;
+}
+
+bool FNetSessionRecording::Load(const FString& FilePath)
+{
+	TArray<uint8> FileData;
+
+	if (!FFileHelper::LoadFileToArray(FileData, *FilePath))
+	{
+		return false;
+	}
+
+	FMemoryReader Ar(FileData);
+
+	uint32 Magic = 0;
+	uint16 Version = 0;
+	Ar << Magic;
+	Ar << Version;
+
+	if (Magic != NET_RECORDING_MAGIC || Version != NET_RECORDING_VERSION)
+	{
+		UE_LOG(LogWesternWar, Warning, TEXT("Net Recording | %s is not a net recording or has a different version"), *FilePath);
+		return false;
+	}
+
+	Moves.Empty();
+	Snapshots.Empty();
+
+	while (!Ar.AtEnd() && !Ar.IsError())
+	{
+		uint8 Type = 0;
+		float Time = 0;
+		Ar << Type;
+		Ar << Time;
+
+		if (Type == ENetRecordType::ClientMove)
+		{
+			FRecordedClientMove& Record = Moves[Moves.AddDefaulted()];
+			Record.Time = Time;
+			FNetSessionRecorder::SerializeClientMove(Ar, Record.Move);
+		}
+		else if (Type == ENetRecordType::ServerSnapshot)
+		{
+			FRecordedServerSnapshot& Record = Snapshots[Snapshots.AddDefaulted()];
+			Record.Time = Time;
+			FNetSessionRecorder::SerializeServerSnapshot(Ar, Record.Snapshot);
+		}
+		else
+		{
+			//Truncated or corrupted file, keep what has been read so far
+			break;
+		}
+	}
+
+	return !Ar.IsError() || Moves.Num() > 0;
+}
@@ -0,0 +1,72 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#pragma once
+
+#include "Player/Character/CharacterNetData.h"
+
+#define NET_RECORDING_MAGIC 0x524E5757	//"WWNR"
+#define NET_RECORDING_VERSION 2
+
+namespace ENetRecordType
+{
+	enum Type
+	{
+		ClientMove = 1,		//FClientCharacterData - input & the predicted (client) or reported (server) result
+		ServerSnapshot = 2,	//FServerCharacterData - server simulation result
+	};
+}
+
+struct FRecordedClientMove
+{
+	float Time;
+	FClientCharacterData Move;
+};
+
+struct FRecordedServerSnapshot
+{
+	float Time;
+	FServerCharacterData Snapshot;
+};
+
+/*
+* Net Session Recorder - Append only binary recording of one pawns moves & server snapshots
+* - Records are packed into a memory buffer & written to disk in 64KB blocks, so recording costs one memcpy per record
+* - Enabled with ww.NetRecord 1, files are written to Saved/NetRecordings
+*/
+class WESTERNWAR_API FNetSessionRecorder
+{
+private:
+	FArchive* FileWriter = nullptr;
+	TArray<uint8> Buffer;
+
+	void Flush();
+
+public:
+	~FNetSessionRecorder();
+
+	bool StartRecording(const FString& FilePath);
+	void StopRecording();
+	bool IsRecording() const { return FileWriter != nullptr; }
+
+	void RecordClientMove(const FClientCharacterData& Move, float Time);
+	void RecordServerSnapshot(const FServerCharacterData& Snapshot, float Time);
+
+	static bool IsRecordingEnabled();
+	static FString GetRecordingPath(const AActor* RecordedActor);
+
+	static void SerializeClientMove(FArchive& Ar, FClientCharacterData& Move);
+	static void SerializeServerSnapshot(FArchive& Ar, FServerCharacterData& Snapshot);
+};
+
+/*
+* Loads a recording written by FNetSessionRecorder
+* - The file is read into memory with a single read & parsed in place
+*/
+class WESTERNWAR_API FNetSessionRecording
+{
+public:
+	TArray<FRecordedClientMove> Moves;
+	TArray<FRecordedServerSnapshot> Snapshots;
+
+	bool Load(const FString& FilePath);
+};
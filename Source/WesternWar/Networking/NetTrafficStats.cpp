@@ -0,0 +1,381 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#include "WesternWar.h"
+#include "NetTrafficStats.h"
+
+static TAutoConsoleVariable<int32> CVarNetStatsShow(
+	TEXT("ww.NetStats.Show"),
+	0,
+	TEXT("Show the network traffic stats on screen. 0 - Off, 1 - On"));
+
+static TAutoConsoleVariable<int32> CVarNetStatsAutoExport(
+	TEXT("ww.NetStats.AutoExport"),
+	1,
+	TEXT("Write the network traffic stats to Saved/NetStats as CSV when the session ends. 0 - Off, 1 - On"));
+
+static TAutoConsoleVariable<int32> CVarNetStatsMeasurePayloads(
+	TEXT("ww.NetStats.MeasurePayloads"),
+	0,
+	TEXT("Measure the bits of every counted RPC & replicated struct with the network serializer, always on while the stats are shown. 0 - Off (calls only), 1 - On"));
+
+static FAutoConsoleCommand NetStatsLogCommand(
+	TEXT("ww.NetStats"),
+	TEXT("Log the network traffic stats of this session"),
+	FConsoleCommandDelegate::CreateLambda([]() { FNetTrafficStats::Get().LogStats(); }));
+
+static FAutoConsoleCommand NetStatsResetCommand(
+	TEXT("ww.NetStats.Reset"),
+	TEXT("Reset the network traffic stats"),
+	FConsoleCommandDelegate::CreateLambda([]() { FNetTrafficStats::Get().Reset(); }));
+
+static FAutoConsoleCommandWithWorld NetStatsExportCommand(
+	TEXT("ww.NetStats.Export"),
+	TEXT("Write the network traffic stats to Saved/NetStats as CSV"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World) { FNetTrafficStats::Get().ExportCsv(FNetTrafficStats::GetSessionCsvPath(World)); }));
+
+FNetTrafficStats::FNetTrafficStats()
+{
+	Reset();
+}
+
+FNetTrafficStats& FNetTrafficStats::Get()
+{
+	static FNetTrafficStats Instance;
+	return Instance;
+}
+
+const TCHAR* FNetTrafficStats::GetRpcName(ENetRpc::Type Rpc)
+{
+	switch (Rpc)
+	{
+	case ENetRpc::Server_SendClientCharacterData:
+		return TEXT("Server_SendClientCharacterData");
+	case ENetRpc::ReplicatedCharacterData:
+		return TEXT("ReplicatedCharacterData");
+	case ENetRpc::ReplicatedWeaponState:
+		return TEXT("ReplicatedWeaponState");
+	case ENetRpc::ReplicatedProjectileSpawnData:
+		return TEXT("ReplicatedProjectileSpawnData");
+	case ENetRpc::Client_AcknowledgeMove:
+		return TEXT("Client_AcknowledgeMove");
+	case ENetRpc::Client_CorrectMove:
+		return TEXT("Client_CorrectMove");
+	case ENetRpc::Server_RequestCorrection:
+		return TEXT("Server_RequestCorrection");
+	case ENetRpc::Server_SendGunFire:
+		return TEXT("Server_SendGunFire");
+	case ENetRpc::Server_SendReload:
+		return TEXT("Server_SendReload");
+	case ENetRpc::Server_SendAimDownSights:
+		return TEXT("Server_SendAimDownSights");
+	case ENetRpc::MultiCastClient_ReplicateGunFireToClients:
+		return TEXT("MultiCastClient_ReplicateGunFireToClients");
+	case ENetRpc::Server_SendMeleeSwing:
+		return TEXT("Server_SendMeleeSwing");
+	case ENetRpc::Server_PickUpItem:
+		return TEXT("Server_PickUpItem");
+	case ENetRpc::Server_DropItem:
+		return TEXT("Server_DropItem");
+	case ENetRpc::Client_BeginKillcamClip:
+		return TEXT("Client_BeginKillcamClip");
+	case ENetRpc::Client_ReceiveKillcamChunk:
+		return TEXT("Client_ReceiveKillcamChunk");
+	case ENetRpc::Client_ConfirmHits:
+		return TEXT("Client_ConfirmHits");
+	case ENetRpc::Client_RejectProjectiles:
+		return TEXT("Client_RejectProjectiles");
+	default:
+		return TEXT("Unknown");
+	}
+}
+
+//NumReceivers is used for multicasts, which the server sends once per client connection
+void FNetTrafficStats::RecordRpcSent(ENetRpc::Type Rpc, int32 Bits, int32 NumReceivers)
+{
+	FNetRpcTrafficCounter& Counter = RpcCounters[Rpc];
+
+	Counter.CallsSent += NumReceivers;
+	Counter.BitsSent += Bits * NumReceivers;
+	Counter.WindowBitsSent += Bits * NumReceivers;
+}
+
+void FNetTrafficStats::RecordRpcReceived(ENetRpc::Type Rpc, int32 Bits)
+{
+	FNetRpcTrafficCounter& Counter = RpcCounters[Rpc];
+
+	Counter.CallsReceived++;
+	Counter.BitsReceived += Bits;
+	Counter.WindowBitsReceived += Bits;
+}
+
+/*
+* Write a struct the way it goes into a packet
+* - Bit packed structs (NetSerialize) are measured with their own serializer, other structs property by property
+* - Object references are counted at NET_OBJECT_REFERENCE_BITS, there is no package map to resolve them with
+*/
+static void SerializeStructForSize(FNetBitWriter& Writer, const UScriptStruct* Struct, void* Data)
+{
+	if (Struct->StructFlags & STRUCT_NetSerializeNative)
+	{
+		bool bSuccess = true;
+		Struct->GetCppStructOps()->NetSerialize(Writer, nullptr, bSuccess, Data);
+		return;
+	}
+
+	for (TFieldIterator<UProperty> It(Struct); It; ++It)
+	{
+		UProperty* Property = *It;
+
+		if (Property->HasAnyPropertyFlags(CPF_RepSkip))
+		{
+			continue;
+		}
+
+		for (int32 i = 0; i < Property->ArrayDim; i++)
+		{
+			void* Value = Property->ContainerPtrToValuePtr<void>(Data, i);
+
+			if (UStructProperty* StructProperty = Cast<UStructProperty>(Property))
+			{
+				SerializeStructForSize(Writer, StructProperty->Struct, Value);
+			}
+			else if (Property->IsA(UObjectPropertyBase::StaticClass()))
+			{
+				uint32 Reference = 0;
+				Writer.SerializeBits(&Reference, NET_OBJECT_REFERENCE_BITS);
+			}
+			else
+			{
+				Property->NetSerializeItem(Writer, nullptr, Value);
+			}
+		}
+	}
+}
+
+int32 FNetTrafficStats::GetSerializedBits(const UScriptStruct* Struct, const void* Data)
+{
+	if (!Struct || !Data || !IsPayloadMeasuringEnabled())
+	{
+		return 0;
+	}
+
+	FNetBitWriter Writer(nullptr, 1024);
+	SerializeStructForSize(Writer, Struct, const_cast<void*>(Data));
+
+	return (int32)Writer.GetNumBits();
+}
+
+void FNetTrafficStats::RecordMisprediction(ENetMispredictionCause::Type Cause)
+{
+	Mispredictions[Cause]++;
+}
+
+void FNetTrafficStats::RecordReplay(int32 ReplayDepth)
+{
+	Replays++;
+	MaxReplayDepth = FMath::Max(MaxReplayDepth, ReplayDepth);
+
+	//Power of two buckets
+	const int32 Bucket = ReplayDepth > 0 ? FMath::FloorLog2(ReplayDepth) : 0;
+	ReplayDepthHistogram[FMath::Min(Bucket, NET_REPLAY_DEPTH_BUCKETS - 1)]++;
+}
+
+void FNetTrafficStats::RecordInterpolationUnderrun()
+{
+	InterpolationUnderruns++;
+}
+
+void FNetTrafficStats::RecordInputBufferUnderrun()
+{
+	InputBufferUnderruns++;
+}
+
+void FNetTrafficStats::RecordInputBufferOverflow()
+{
+	InputBufferOverflows++;
+}
+
+void FNetTrafficStats::Tick(float DeltaTime, const UNetDriver* NetDriver)
+{
+	WindowTime += DeltaTime;
+
+	if (WindowTime < 1)
+	{
+		return;
+	}
+
+	for (FNetRpcTrafficCounter& Counter : RpcCounters)
+	{
+		Counter.SendBytesPerSecond = Counter.WindowBitsSent / 8.0f / WindowTime;
+		Counter.ReceiveBytesPerSecond = Counter.WindowBitsReceived / 8.0f / WindowTime;
+		Counter.PeakSendBytesPerSecond = FMath::Max(Counter.PeakSendBytesPerSecond, Counter.SendBytesPerSecond);
+		Counter.PeakReceiveBytesPerSecond = FMath::Max(Counter.PeakReceiveBytesPerSecond, Counter.ReceiveBytesPerSecond);
+		Counter.WindowBitsSent = 0;
+		Counter.WindowBitsReceived = 0;
+	}
+
+	//The net driver keeps its own per second totals of everything it sent & received
+	if (NetDriver)
+	{
+		NetDriverCounter.SendBytesPerSecond = NetDriver->OutBytesPerSecond;
+		NetDriverCounter.ReceiveBytesPerSecond = NetDriver->InBytesPerSecond;
+		NetDriverCounter.PeakSendBytesPerSecond = FMath::Max(NetDriverCounter.PeakSendBytesPerSecond, NetDriverCounter.SendBytesPerSecond);
+		NetDriverCounter.PeakReceiveBytesPerSecond = FMath::Max(NetDriverCounter.PeakReceiveBytesPerSecond, NetDriverCounter.ReceiveBytesPerSecond);
+	}
+
+	WindowTime = 0;
+}
+
+void FNetTrafficStats::Reset()
+{
+	for (FNetRpcTrafficCounter& Counter : RpcCounters)
+	{
+		Counter = FNetRpcTrafficCounter();
+	}
+
+	NetDriverCounter = FNetDriverTrafficCounter();
+
+	FMemory::Memzero(Mispredictions, sizeof(Mispredictions));
+	FMemory::Memzero(ReplayDepthHistogram, sizeof(ReplayDepthHistogram));
+
+	Replays = 0;
+	MaxReplayDepth = 0;
+	InterpolationUnderruns = 0;
+	InputBufferUnderruns = 0;
+	InputBufferOverflows = 0;
+	WindowTime = 0;
+	SessionStartTime = FPlatformTime::Seconds();
+}
+
+void FNetTrafficStats::GetSummaryLines(TArray<FString>& OutLines) const
+{
+	for (int32 i = 0; i < ENetRpc::Count; i++)
+	{
+		const FNetRpcTrafficCounter& Counter = RpcCounters[i];
+
+		if (Counter.CallsSent == 0 && Counter.CallsReceived == 0)
+		{
+			continue;
+		}
+
+		OutLines.Add(FString::Printf(TEXT("%s | Sent: %d calls %.0f B (%.1f bits/call, %.0f B/s) | Received: %d calls %.0f B (%.1f bits/call, %.0f B/s)"),
+			GetRpcName((ENetRpc::Type)i),
+			Counter.CallsSent, Counter.BitsSent / 8.0, Counter.CallsSent > 0 ? (double)Counter.BitsSent / Counter.CallsSent : 0.0, Counter.SendBytesPerSecond,
+			Counter.CallsReceived, Counter.BitsReceived / 8.0, Counter.CallsReceived > 0 ? (double)Counter.BitsReceived / Counter.CallsReceived : 0.0, Counter.ReceiveBytesPerSecond));
+	}
+
+	OutLines.Add(FString::Printf(TEXT("Net Driver (all traffic) | Send: %.0f B/s (Peak %.0f B/s) | Receive: %.0f B/s (Peak %.0f B/s)"),
+		NetDriverCounter.SendBytesPerSecond, NetDriverCounter.PeakSendBytesPerSecond, NetDriverCounter.ReceiveBytesPerSecond, NetDriverCounter.PeakReceiveBytesPerSecond));
+
+	OutLines.Add(FString::Printf(TEXT("Mispredictions | Location: %d | Rotation: %d | Movement State: %d"),
+		Mispredictions[ENetMispredictionCause::Location], Mispredictions[ENetMispredictionCause::Rotation], Mispredictions[ENetMispredictionCause::MovementState]));
+
+	FString Histogram;
+	for (int32 i = 0; i < NET_REPLAY_DEPTH_BUCKETS; i++)
+	{
+		Histogram += FString::Printf(TEXT(" %d+: %d"), 1 << i, ReplayDepthHistogram[i]);
+	}
+
+	OutLines.Add(FString::Printf(TEXT("Replays: %d | Max Depth: %d |%s"), Replays, MaxReplayDepth, *Histogram));
+	OutLines.Add(FString::Printf(TEXT("Interpolation Underruns: %d | Input Buffer Underruns: %d | Input Buffer Overflows: %d"), InterpolationUnderruns, InputBufferUnderruns, InputBufferOverflows));
+}
+
+void FNetTrafficStats::LogStats() const
+{
+	TArray<FString> Lines;
+	GetSummaryLines(Lines);
+
+	UE_LOG(LogWesternWar, Log, TEXT("Net Stats | Session Length: %.1f s"), FPlatformTime::Seconds() - SessionStartTime);
+
+	if (!IsPayloadMeasuringEnabled())
+	{
+		UE_LOG(LogWesternWar, Log, TEXT("Net Stats | Payloads were not measured, enable ww.NetStats.MeasurePayloads for the bits of the netcode RPCs"));
+	}
+
+	for (const FString& Line : Lines)
+	{
+		UE_LOG(LogWesternWar, Log, TEXT("Net Stats | %s"), *Line);
+	}
+}
+
+bool FNetTrafficStats::ExportCsv(const FString& FilePath) const
+{
+	const double SessionLength = FMath::Max(FPlatformTime::Seconds() - SessionStartTime, 0.001);
+
+	FString Csv = TEXT("Rpc,CallsSent,BitsSent,AvgSendBytesPerSecond,PeakSendBytesPerSecond,CallsReceived,BitsReceived,AvgReceiveBytesPerSecond,PeakReceiveBytesPerSecond\n");
+
+	for (int32 i = 0; i < ENetRpc::Count; i++)
+	{
+		const FNetRpcTrafficCounter& Counter = RpcCounters[i];
+
+		Csv += FString::Printf(TEXT("%s,%d,%lld,%.1f,%.1f,%d,%lld,%.1f,%.1f\n"),
+			GetRpcName((ENetRpc::Type)i),
+			Counter.CallsSent, Counter.BitsSent, Counter.BitsSent / 8.0 / SessionLength, Counter.PeakSendBytesPerSecond,
+			Counter.CallsReceived, Counter.BitsReceived, Counter.BitsReceived / 8.0 / SessionLength, Counter.PeakReceiveBytesPerSecond);
+	}
+
+	Csv += TEXT("\nCounter,Value\n");
+	Csv += FString::Printf(TEXT("SessionLengthSeconds,%.1f\n"), SessionLength);
+	Csv += FString::Printf(TEXT("NetDriverPeakSendBytesPerSecond,%.1f\n"), NetDriverCounter.PeakSendBytesPerSecond);
+	Csv += FString::Printf(TEXT("NetDriverPeakReceiveBytesPerSecond,%.1f\n"), NetDriverCounter.PeakReceiveBytesPerSecond);
+	Csv += FString::Printf(TEXT("MispredictionsLocation,%d\n"), Mispredictions[ENetMispredictionCause::Location]);
+	Csv += FString::Printf(TEXT("MispredictionsRotation,%d\n"), Mispredictions[ENetMispredictionCause::Rotation]);
+	Csv += FString::Printf(TEXT("MispredictionsMovementState,%d\n"), Mispredictions[ENetMispredictionCause::MovementState]);
+	Csv += FString::Printf(TEXT("Replays,%d\n"), Replays);
+	Csv += FString::Printf(TEXT("MaxReplayDepth,%d\n"), MaxReplayDepth);
+
+	for (int32 i = 0; i < NET_REPLAY_DEPTH_BUCKETS; i++)
+	{
+		Csv += FString::Printf(TEXT("ReplayDepth%dPlus,%d\n"), 1 << i, ReplayDepthHistogram[i]);
+	}
+
+	Csv += FString::Printf(TEXT("InterpolationUnderruns,%d\n"), InterpolationUnderruns);
+	Csv += FString::Printf(TEXT("InputBufferUnderruns,%d\n"), InputBufferUnderruns);
+	Csv += FString::Printf(TEXT("InputBufferOverflows,%d\n"), InputBufferOverflows);
+
+	const bool bSaved = FFileHelper::SaveStringToFile(Csv, *FilePath);
+
+	UE_LOG(LogWesternWar, Log, TEXT("Net Stats | %s %s"), bSaved ? TEXT("Exported to") : TEXT("Failed to export to"), *FilePath);
+
+	return bSaved;
+}
+
+FString FNetTrafficStats::GetSessionCsvPath(UWorld* World)
+{
+	FString NetMode = TEXT("Standalone");
+
+	if (World)
+	{
+		switch (World->GetNetMode())
+		{
+		case NM_DedicatedServer:
+			NetMode = TEXT("DedicatedServer");
+			break;
+		case NM_ListenServer:
+			NetMode = TEXT("ListenServer");
+			break;
+		case NM_Client:
+			NetMode = TEXT("Client");
+			break;
+		default:
+			break;
+		}
+	}
+
+	return FPaths::GameSavedDir() / TEXT("NetStats") / FString::Printf(TEXT("NetStats-%s-%s.csv"), *NetMode, *FDateTime::Now().ToString());
+}
+
+bool FNetTrafficStats::IsOnScreenDisplayEnabled()
+{
+	return CVarNetStatsShow.GetValueOnGameThread() != 0;
+}
+
+bool FNetTrafficStats::IsAutoExportEnabled()
+{
+	return CVarNetStatsAutoExport.GetValueOnGameThread() != 0;
+}
+
+bool FNetTrafficStats::IsPayloadMeasuringEnabled()
+{
+	return CVarNetStatsMeasurePayloads.GetValueOnGameThread() != 0 || IsOnScreenDisplayEnabled();
+}
@@ -0,0 +1,163 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#pragma once
+
+namespace ENetRpc
+{
+	enum Type
+	{
+		Server_SendClientCharacterData,
+		ReplicatedCharacterData,	//Replicated property, not an RPC
+		ReplicatedWeaponState,		//Replicated property, not an RPC
+		ReplicatedProjectileSpawnData,	//Replicated property, not an RPC
+		Client_AcknowledgeMove,
+		Client_CorrectMove,
+		Server_RequestCorrection,
+		Server_SendGunFire,
+		Server_SendReload,
+		Server_SendAimDownSights,
+		MultiCastClient_ReplicateGunFireToClients,
+		Server_SendMeleeSwing,
+		Server_PickUpItem,
+		Server_DropItem,
+		Client_BeginKillcamClip,
+		Client_ReceiveKillcamChunk,
+		Client_ConfirmHits,
+		Client_RejectProjectiles,
+		Count,
+	};
+}
+
+namespace ENetMispredictionCause
+{
+	enum Type
+	{
+		Location,
+		Rotation,
+		MovementState,	//Velocity or jump state, the transform was within the error margin
+		Count,
+	};
+}
+
+#define NET_REPLAY_DEPTH_BUCKETS 7	//1, 2-3, 4-7, 8-15, 16-31, 32-63, 64+ replayed moves
+
+//Wire sizes of RPC parameters that are not measured with the network serializer
+#define NET_ARRAY_NUM_BITS 16		//Element count of a dynamic array parameter
+#define NET_OBJECT_REFERENCE_BITS 32	//Upper bound of a packed NetGUID
+
+struct FNetRpcTrafficCounter
+{
+	int64 BitsSent = 0;
+	int64 BitsReceived = 0;
+	int32 CallsSent = 0;
+	int32 CallsReceived = 0;
+
+	//Rolling one second window
+	int32 WindowBitsSent = 0;
+	int32 WindowBitsReceived = 0;
+	float SendBytesPerSecond = 0;
+	float ReceiveBytesPerSecond = 0;
+	float PeakSendBytesPerSecond = 0;
+	float PeakReceiveBytesPerSecond = 0;
+};
+
+struct FNetDriverTrafficCounter
+{
+	//All traffic of the net driver, packet headers, property replication & engine RPCs included
+	float SendBytesPerSecond = 0;
+	float ReceiveBytesPerSecond = 0;
+	float PeakSendBytesPerSecond = 0;
+	float PeakReceiveBytesPerSecond = 0;
+};
+
+/*
+* Network Traffic Stats - Per process counters for the netcode
+* - Per RPC & replicated property bit & call counters with per second rates
+* - Payloads are measured with the network serializer (GetSerializedBits), so bit packed structs are counted at their wire size,
+*   packet & bunch headers are only part of the net driver totals
+* - Measuring walks the struct properties for every call, it only runs with ww.NetStats.MeasurePayloads or the on screen display,
+*   otherwise only the calls & the net driver totals are counted
+* - Mispredictions by cause, replay depth histogram, interpolation buffer & server input buffer underruns
+* - Shown live with ww.NetStats / ww.NetStats.Show, written to Saved/NetStats as CSV at the end of every session
+*/
+class WESTERNWAR_API FNetTrafficStats
+{
+private:
+	FNetRpcTrafficCounter RpcCounters[ENetRpc::Count];
+	FNetDriverTrafficCounter NetDriverCounter;
+	int32 Mispredictions[ENetMispredictionCause::Count];
+	int32 ReplayDepthHistogram[NET_REPLAY_DEPTH_BUCKETS];
+	int32 Replays = 0;
+	int32 MaxReplayDepth = 0;
+	int32 InterpolationUnderruns = 0;
+	int32 InputBufferUnderruns = 0;
+	int32 InputBufferOverflows = 0;
+
+	float WindowTime = 0;
+	double SessionStartTime = 0;
+
+public:
+	FNetTrafficStats();
+
+	static FNetTrafficStats& Get();
+	static const TCHAR* GetRpcName(ENetRpc::Type Rpc);
+
+	void RecordRpcSent(ENetRpc::Type Rpc, int32 Bits, int32 NumReceivers = 1);
+	void RecordRpcReceived(ENetRpc::Type Rpc, int32 Bits);
+	void RecordMisprediction(ENetMispredictionCause::Type Cause);
+	void RecordReplay(int32 ReplayDepth);
+	void RecordInterpolationUnderrun();
+	void RecordInputBufferUnderrun();
+	void RecordInputBufferOverflow();
+
+	//Rolls the per second rate windows & samples the totals of the net driver, called once per frame
+	void Tick(float DeltaTime, const UNetDriver* NetDriver);
+
+	//Bits a struct takes in a packet, measured by running the network serializer of its properties into a bit writer
+	//0 while payload measuring is off, so the per move paths do not pay for stats nobody looks at
+	static int32 GetSerializedBits(const UScriptStruct* Struct, const void* Data);
+
+	template<typename StructType>
+	static int32 GetSerializedBits(const StructType& Value)
+	{
+		return GetSerializedBits(StructType::StaticStruct(), &Value);
+	}
+
+	template<typename StructType>
+	static int32 GetSerializedBits(const TArray<StructType>& Values)
+	{
+		if (!IsPayloadMeasuringEnabled())
+		{
+			return 0;
+		}
+
+		int32 Bits = NET_ARRAY_NUM_BITS;
+
+		for (const StructType& Value : Values)
+		{
+			Bits += GetSerializedBits(StructType::StaticStruct(), &Value);
+		}
+
+		return Bits;
+	}
+
+	void Reset();
+
+	const FNetRpcTrafficCounter& GetRpcCounter(ENetRpc::Type Rpc) const { return RpcCounters[Rpc]; }
+	int32 GetMispredictions(ENetMispredictionCause::Type Cause) const { return Mispredictions[Cause]; }
+	int32 GetReplays() const { return Replays; }
+	int32 GetInterpolationUnderruns() const { return InterpolationUnderruns; }
+	int32 GetInputBufferUnderruns() const { return InputBufferUnderruns; }
+	int32 GetInputBufferOverflows() const { return InputBufferOverflows; }
+
+	void GetSummaryLines(TArray<FString>& OutLines) const;
+	void LogStats() const;
+	bool ExportCsv(const FString& FilePath) const;
+
+	//Default CSV path for this session - Saved/NetStats/NetStats-<NetMode>-<Date>.csv
+	static FString GetSessionCsvPath(UWorld* World);
+
+	static bool IsOnScreenDisplayEnabled();
+	static bool IsAutoExportEnabled();
+	static bool IsPayloadMeasuringEnabled();
+};
@@ -0,0 +1,128 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#include "WesternWar.h"
+#include "NetcodeTimingStats.h"
+
+DEFINE_STAT(STAT_MoveCharacter);
+DEFINE_STAT(STAT_RewindAndReplay);
+DEFINE_STAT(STAT_CompareServerToClientSimulationResults);
+DEFINE_STAT(STAT_InterpolateMovementData);
+DEFINE_STAT(STAT_IsPlayerGrounded);
+DEFINE_STAT(STAT_RewindServerCharacterLocation);
+DEFINE_STAT(STAT_ResolveMeleeSwings);
+DEFINE_STAT(STAT_NetcodeFrameTime);
+DEFINE_STAT(STAT_NetcodeTimePerPlayer);
+DEFINE_STAT(STAT_NetcodePlayersSimulated);
+DEFINE_STAT(STAT_NetcodeSimulatedMoves);
+DEFINE_STAT(STAT_NetcodeTrustedMoves);
+
+static TAutoConsoleVariable<float> CVarNetcodeBudgetMs(
+	TEXT("ww.Net.BudgetMs"),
+	0,
+	TEXT("Log a warning when the netcode takes longer than this many milliseconds in a frame. 0 - Off"));
+
+static FAutoConsoleCommand NetcodeTimingLogCommand(
+	TEXT("ww.NetTiming"),
+	TEXT("Log the netcode CPU time per frame & per player"),
+	FConsoleCommandDelegate::CreateLambda([]() { FNetcodeTimingStats::Get().LogStats(); }));
+
+FNetcodeTimingStats& FNetcodeTimingStats::Get()
+{
+	static FNetcodeTimingStats Instance;
+	return Instance;
+}
+
+void FNetcodeTimingStats::RegisterPlayer(FNetcodePlayerTiming* PlayerTiming)
+{
+	PlayerTimings.AddUnique(PlayerTiming);
+}
+
+void FNetcodeTimingStats::UnregisterPlayer(FNetcodePlayerTiming* PlayerTiming)
+{
+	PlayerTimings.Remove(PlayerTiming);
+}
+
+void FNetcodeTimingStats::EndScope(uint32 Cycles, FNetcodePlayerTiming* PlayerTiming)
+{
+	ScopeDepth--;
+
+	if (ScopeDepth > 0)
+	{
+		return;
+	}
+
+	CyclesThisFrame += Cycles;
+
+	if (PlayerTiming)
+	{
+		PlayerTiming->CyclesThisFrame += Cycles;
+	}
+}
+
+void FNetcodeTimingStats::EndFrame()
+{
+	//Every world calls this (PIE, listen server & clients in one process), only the first call of an engine frame ends it
+	//The frame then runs from that point to the same point of the next engine frame & holds the netcode of every world once
+	if (LastEndedFrameNumber == GFrameCounter)
+	{
+		return;
+	}
+
+	LastEndedFrameNumber = GFrameCounter;
+
+	const float MicrosecondsPerCycle = FPlatformTime::GetSecondsPerCycle() * 1000000.0f;
+
+	int32 PlayersSimulated = 0;
+	const FNetcodePlayerTiming* SlowestPlayer = nullptr;
+
+	for (FNetcodePlayerTiming* PlayerTiming : PlayerTimings)
+	{
+		PlayerTiming->LastFrameMicroseconds = PlayerTiming->CyclesThisFrame * MicrosecondsPerCycle;
+		PlayerTiming->CyclesThisFrame = 0;
+
+		if (PlayerTiming->LastFrameMicroseconds <= 0)
+		{
+			continue;
+		}
+
+		PlayersSimulated++;
+		PlayerTiming->AverageMicroseconds = FMath::Lerp(PlayerTiming->AverageMicroseconds, PlayerTiming->LastFrameMicroseconds, 0.05f);
+		PlayerTiming->PeakMicroseconds = FMath::Max(PlayerTiming->PeakMicroseconds, PlayerTiming->LastFrameMicroseconds);
+
+		if (!SlowestPlayer || PlayerTiming->LastFrameMicroseconds > SlowestPlayer->LastFrameMicroseconds)
+		{
+			SlowestPlayer = PlayerTiming;
+		}
+	}
+
+	LastFrameMilliseconds = CyclesThisFrame * MicrosecondsPerCycle / 1000.0f;
+	PeakFrameMilliseconds = FMath::Max(PeakFrameMilliseconds, LastFrameMilliseconds);
+	CyclesThisFrame = 0;
+
+	SET_FLOAT_STAT(STAT_NetcodeFrameTime, LastFrameMilliseconds);
+	SET_FLOAT_STAT(STAT_NetcodeTimePerPlayer, PlayersSimulated > 0 ? LastFrameMilliseconds * 1000.0f / PlayersSimulated : 0);
+	SET_DWORD_STAT(STAT_NetcodePlayersSimulated, PlayersSimulated);
+
+	const float BudgetMs = CVarNetcodeBudgetMs.GetValueOnGameThread();
+
+	if (BudgetMs > 0 && LastFrameMilliseconds > BudgetMs)
+	{
+		FramesOverBudget++;
+
+		UE_LOG(LogWesternWar, Warning, TEXT("Netcode over budget | %.3f ms / %.3f ms | Players Simulated: %d | Slowest: %s (%.1f us)"),
+			LastFrameMilliseconds, BudgetMs, PlayersSimulated,
+			SlowestPlayer ? *GetNameSafe(SlowestPlayer->Owner) : TEXT("None"), SlowestPlayer ? SlowestPlayer->LastFrameMicroseconds : 0);
+	}
+}
+
+void FNetcodeTimingStats::LogStats() const
+{
+	UE_LOG(LogWesternWar, Log, TEXT("Netcode Timing | Last Frame: %.3f ms | Peak Frame: %.3f ms | Frames Over Budget: %d | Players: %d"),
+		LastFrameMilliseconds, PeakFrameMilliseconds, FramesOverBudget, PlayerTimings.Num());
+
+	for (const FNetcodePlayerTiming* PlayerTiming : PlayerTimings)
+	{
+		UE_LOG(LogWesternWar, Log, TEXT("Netcode Timing | %s | Last Frame: %.1f us | Average: %.1f us | Peak: %.1f us"),
+			*GetNameSafe(PlayerTiming->Owner), PlayerTiming->LastFrameMicroseconds, PlayerTiming->AverageMicroseconds, PlayerTiming->PeakMicroseconds);
+	}
+}
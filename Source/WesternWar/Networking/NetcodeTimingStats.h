@@ -0,0 +1,92 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#pragma once
+
+/*
+* Netcode CPU timing
+* - "stat WesternWarNetcode" shows the scoped cycle counters of the netcode hot paths & the per frame aggregates
+* - Running with -statnamedevents also emits the scopes as named events for external profilers
+*/
+DECLARE_STATS_GROUP(TEXT("WesternWar Netcode"), STATGROUP_WesternWarNetcode, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("MoveCharacter"), STAT_MoveCharacter, STATGROUP_WesternWarNetcode, WESTERNWAR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("RewindAndReplay"), STAT_RewindAndReplay, STATGROUP_WesternWarNetcode, WESTERNWAR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("CompareServerToClientSimulationResults"), STAT_CompareServerToClientSimulationResults, STATGROUP_WesternWarNetcode, WESTERNWAR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("InterpolateMovementData"), STAT_InterpolateMovementData, STATGROUP_WesternWarNetcode, WESTERNWAR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("IsPlayerGrounded"), STAT_IsPlayerGrounded, STATGROUP_WesternWarNetcode, WESTERNWAR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("RewindServerCharacterLocation"), STAT_RewindServerCharacterLocation, STATGROUP_WesternWarNetcode, WESTERNWAR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ResolveMeleeSwings"), STAT_ResolveMeleeSwings, STATGROUP_WesternWarNetcode, WESTERNWAR_API);
+
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Netcode Time Per Frame (ms)"), STAT_NetcodeFrameTime, STATGROUP_WesternWarNetcode, WESTERNWAR_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Netcode Time Per Player (us)"), STAT_NetcodeTimePerPlayer, STATGROUP_WesternWarNetcode, WESTERNWAR_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Players Simulated"), STAT_NetcodePlayersSimulated, STATGROUP_WesternWarNetcode, WESTERNWAR_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Server Moves Simulated"), STAT_NetcodeSimulatedMoves, STATGROUP_WesternWarNetcode, WESTERNWAR_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Server Moves Trusted"), STAT_NetcodeTrustedMoves, STATGROUP_WesternWarNetcode, WESTERNWAR_API);
+
+struct FNetcodePlayerTiming
+{
+	const AActor* Owner = nullptr;
+	uint32 CyclesThisFrame = 0;
+	float LastFrameMicroseconds = 0;
+	float AverageMicroseconds = 0;	//Exponential moving average of the frames the player was simulated in
+	float PeakMicroseconds = 0;
+};
+
+/*
+* Netcode Timing Stats - Per frame & per player aggregates of the netcode scopes
+* - Only the outer most scope adds to the aggregates, so nested scopes (IsPlayerGrounded inside MoveCharacter) are not counted twice
+* - ww.Net.BudgetMs logs a warning for every frame the netcode goes over the budget
+*/
+class WESTERNWAR_API FNetcodeTimingStats
+{
+private:
+	TArray<FNetcodePlayerTiming*> PlayerTimings;
+
+	uint32 CyclesThisFrame = 0;
+	int32 ScopeDepth = 0;
+	uint64 LastEndedFrameNumber = 0;
+
+	float LastFrameMilliseconds = 0;
+	float PeakFrameMilliseconds = 0;
+	int32 FramesOverBudget = 0;
+
+public:
+	static FNetcodeTimingStats& Get();
+
+	void RegisterPlayer(FNetcodePlayerTiming* PlayerTiming);
+	void UnregisterPlayer(FNetcodePlayerTiming* PlayerTiming);
+
+	void BeginScope() { ScopeDepth++; }
+	void EndScope(uint32 Cycles, FNetcodePlayerTiming* PlayerTiming);
+
+	//Publishes the aggregates of the frame & checks the budget, called by every world, only ends the engine frame once
+	void EndFrame();
+
+	float GetLastFrameMilliseconds() const { return LastFrameMilliseconds; }
+
+	void LogStats() const;
+};
+
+class FScopedNetcodeTimer
+{
+private:
+	FNetcodePlayerTiming* PlayerTiming;
+	uint32 StartCycles;
+
+public:
+	FScopedNetcodeTimer(FNetcodePlayerTiming* InPlayerTiming)
+		: PlayerTiming(InPlayerTiming), StartCycles(FPlatformTime::Cycles())
+	{
+		FNetcodeTimingStats::Get().BeginScope();
+	}
+
+	~FScopedNetcodeTimer()
+	{
+		FNetcodeTimingStats::Get().EndScope(FPlatformTime::Cycles() - StartCycles, PlayerTiming);
+	}
+};
+
+//Cycle stat for the stats system & profilers + the per frame / per player netcode aggregates
+#define SCOPE_NETCODE_TIMER(Stat, PlayerTiming) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	FScopedNetcodeTimer NetcodeTimer_##Stat(PlayerTiming)
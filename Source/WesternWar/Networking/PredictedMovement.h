@@ -0,0 +1,185 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#pragma once
+
+#define PREDICTED_MOVE_ID_RANGE 400	//Move IDs run from 1 to 400 & wrap around
+
+/*
+* Move IDs - anything less than half the ID range ahead of another ID is newer than it
+*/
+namespace PredictedMoveID
+{
+	//Moves from FromID forward to ToID
+	static FORCEINLINE int32 Distance(int32 FromID, int32 ToID)
+	{
+		return ((ToID - FromID) % PREDICTED_MOVE_ID_RANGE + PREDICTED_MOVE_ID_RANGE) % PREDICTED_MOVE_ID_RANGE;
+	}
+
+	static FORCEINLINE bool IsNewer(int32 ID, int32 ThanID)
+	{
+		const int32 MovesAhead = Distance(ThanID, ID);
+
+		return MovesAhead != 0 && MovesAhead < PREDICTED_MOVE_ID_RANGE / 2;
+	}
+
+	static FORCEINLINE int16 Next(int16 ID)
+	{
+		return ID % PREDICTED_MOVE_ID_RANGE + 1;
+	}
+}
+
+/*
+* Prediction Ring - fixed capacity ring buffer sized at compile time, nothing is allocated per move
+* - Index 0 is the oldest element, adding to a full ring overwrites the oldest element
+*/
+template <typename ElementType, int32 Capacity>
+class TPredictionRing
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Prediction ring capacity must be a power of two");
+
+private:
+	ElementType Elements[Capacity];
+	int32 Head = 0;
+	int32 Count = 0;
+
+public:
+	int32 Num() const { return Count; }
+	bool IsEmpty() const { return Count == 0; }
+	bool IsFull() const { return Count == Capacity; }
+
+	ElementType& operator[](int32 Index) { check(Index >= 0 && Index < Count); return Elements[(Head + Index) & (Capacity - 1)]; }
+	const ElementType& operator[](int32 Index) const { check(Index >= 0 && Index < Count); return Elements[(Head + Index) & (Capacity - 1)]; }
+
+	ElementType& Oldest() { return (*this)[0]; }
+	ElementType& Newest() { return (*this)[Count - 1]; }
+	const ElementType& Oldest() const { return (*this)[0]; }
+	const ElementType& Newest() const { return (*this)[Count - 1]; }
+
+	void Add(const ElementType& Element)
+	{
+		if (Count == Capacity)
+		{
+			PopOldest();
+		}
+
+		Elements[(Head + Count) & (Capacity - 1)] = Element;
+		Count++;
+	}
+
+	void PopOldest(int32 NumToPop = 1)
+	{
+		NumToPop = FMath::Min(NumToPop, Count);
+		Head = (Head + NumToPop) & (Capacity - 1);
+		Count -= NumToPop;
+	}
+
+	void Reset()
+	{
+		Head = 0;
+		Count = 0;
+	}
+};
+
+/*
+* Predicted Movement - client side prediction & reconciliation for any predicted pawn (characters, vehicles, mounts)
+* - The pawn supplies StateType (simulation result), InputType (one move) & StepType (the simulation), every call into
+*   the step is resolved at compile time, so the replay loop has no virtual calls
+* - The saved move buffer is sized by a template argument, the prediction state of a pawn is one allocation-free member
+*
+* StepType has to provide:
+* - static int16 GetMoveID(const InputType& Input)
+* - void Simulate(const InputType& Input, StateType& State) - one move, the step object can reference the pawn it moves
+* - static void Quantize(StateType& State) - rounds the state to the network precision, so prediction & server results match
+* - bool IsWithinErrorMargin(const StateType& Predicted, const StateType& Authoritative) const
+*/
+template <typename StateType, typename InputType, typename StepType, int32 MaxSavedMoves = 128>
+class TPredictedMovement
+{
+public:
+	struct FSavedMove
+	{
+		InputType Input;
+		StateType State;	//Predicted result of the input
+	};
+
+private:
+	TPredictionRing<FSavedMove, MaxSavedMoves> SavedMoves;
+
+public:
+	//Simulates the move from State & saves it until the authority acknowledges or corrects it
+	void Predict(StepType& Step, const InputType& Input, StateType& State)
+	{
+		Step.Simulate(Input, State);
+		StepType::Quantize(State);
+
+		SaveMove(Input, State);
+	}
+
+	//Saves a move the pawn already simulated, e.g. moves combined over several frames before they are sent
+	void SaveMove(const InputType& Input, const StateType& State)
+	{
+		FSavedMove SavedMove;
+		SavedMove.Input = Input;
+		SavedMove.State = State;
+		SavedMoves.Add(SavedMove);
+	}
+
+	//Drops every move up to & including the move ID, false if the move is no longer stored (already corrected)
+	bool AcknowledgeMove(int16 MoveID, FSavedMove& OutAcknowledgedMove)
+	{
+		while (!SavedMoves.IsEmpty() && PredictedMoveID::IsNewer(MoveID, StepType::GetMoveID(SavedMoves.Oldest().Input)))
+		{
+			SavedMoves.PopOldest();
+		}
+
+		if (SavedMoves.IsEmpty() || StepType::GetMoveID(SavedMoves.Oldest().Input) != MoveID)
+		{
+			return false;
+		}
+
+		OutAcknowledgedMove = SavedMoves.Oldest();
+		SavedMoves.PopOldest();
+
+		return true;
+	}
+
+	/*
+	* Compares the authoritative result of a move with its prediction
+	* - Moves up to & including the move are dropped, on a misprediction the newer moves are replayed from the authoritative state
+	* - Returns true if State was corrected
+	*/
+	bool Reconcile(StepType& Step, int16 AuthoritativeMoveID, const StateType& AuthoritativeState, StateType& State)
+	{
+		FSavedMove AcknowledgedMove;
+
+		if (!AcknowledgeMove(AuthoritativeMoveID, AcknowledgedMove) || Step.IsWithinErrorMargin(AcknowledgedMove.State, AuthoritativeState))
+		{
+			return false;
+		}
+
+		State = AuthoritativeState;
+		Replay(Step, State);
+
+		return true;
+	}
+
+	//Re-simulates every saved move from State in place & stores the new predictions, returns the number of replayed moves
+	int32 Replay(StepType& Step, StateType& State)
+	{
+		for (int32 i = 0; i < SavedMoves.Num(); i++)
+		{
+			FSavedMove& SavedMove = SavedMoves[i];
+
+			Step.Simulate(SavedMove.Input, State);
+			StepType::Quantize(State);
+
+			SavedMove.State = State;
+		}
+
+		return SavedMoves.Num();
+	}
+
+	int32 GetNumSavedMoves() const { return SavedMoves.Num(); }
+	const FSavedMove& GetSavedMove(int32 Index) const { return SavedMoves[Index]; }	//0 is the oldest move
+	void ResetSavedMoves() { SavedMoves.Reset(); }
+};
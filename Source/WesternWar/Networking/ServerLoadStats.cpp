@@ -0,0 +1,83 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#include "WesternWar.h"
+#include "ServerLoadStats.h"
+
+static FAutoConsoleCommand ServerLoadLogCommand(
+	TEXT("ww.ServerLoad"),
+	TEXT("Log the server frame time per connected player count"),
+	FConsoleCommandDelegate::CreateLambda([]() { FServerLoadStats::Get().LogStats(); }));
+
+static FAutoConsoleCommand ServerLoadResetCommand(
+	TEXT("ww.ServerLoad.Reset"),
+	TEXT("Reset the server load stats"),
+	FConsoleCommandDelegate::CreateLambda([]() { FServerLoadStats::Get().Reset(); }));
+
+FServerLoadStats& FServerLoadStats::Get()
+{
+	static FServerLoadStats Instance;
+	return Instance;
+}
+
+void FServerLoadStats::RecordFrame(int32 NumPlayers, float GameThreadMilliseconds, float NetcodeMilliseconds)
+{
+	FServerLoadBucket& Bucket = Buckets.FindOrAdd(NumPlayers);
+
+	Bucket.Frames++;
+	Bucket.TotalGameThreadMilliseconds += GameThreadMilliseconds;
+	Bucket.PeakGameThreadMilliseconds = FMath::Max(Bucket.PeakGameThreadMilliseconds, GameThreadMilliseconds);
+	Bucket.TotalNetcodeMilliseconds += NetcodeMilliseconds;
+	Bucket.PeakNetcodeMilliseconds = FMath::Max(Bucket.PeakNetcodeMilliseconds, NetcodeMilliseconds);
+}
+
+void FServerLoadStats::Reset()
+{
+	Buckets.Empty();
+}
+
+void FServerLoadStats::LogStats() const
+{
+	TArray<int32> PlayerCounts;
+	Buckets.GetKeys(PlayerCounts);
+	PlayerCounts.Sort();
+
+	for (int32 NumPlayers : PlayerCounts)
+	{
+		const FServerLoadBucket& Bucket = Buckets[NumPlayers];
+
+		UE_LOG(LogWesternWar, Log, TEXT("Server Load | Players: %d | Frames: %d | Game Thread Avg: %.2f ms Peak: %.2f ms | Netcode Avg: %.3f ms Peak: %.3f ms"),
+			NumPlayers, Bucket.Frames,
+			Bucket.TotalGameThreadMilliseconds / Bucket.Frames, Bucket.PeakGameThreadMilliseconds,
+			Bucket.TotalNetcodeMilliseconds / Bucket.Frames, Bucket.PeakNetcodeMilliseconds);
+	}
+}
+
+bool FServerLoadStats::ExportCsv(const FString& FilePath) const
+{
+	TArray<int32> PlayerCounts;
+	Buckets.GetKeys(PlayerCounts);
+	PlayerCounts.Sort();
+
+	FString Csv = TEXT("Players,Frames,AvgGameThreadMs,PeakGameThreadMs,AvgNetcodeMs,PeakNetcodeMs\n");
+
+	for (int32 NumPlayers : PlayerCounts)
+	{
+		const FServerLoadBucket& Bucket = Buckets[NumPlayers];
+
+		Csv += FString::Printf(TEXT("%d,%d,%.3f,%.3f,%.4f,%.4f\n"),
+			NumPlayers, Bucket.Frames,
+			Bucket.TotalGameThreadMilliseconds / Bucket.Frames, Bucket.PeakGameThreadMilliseconds,
+			Bucket.TotalNetcodeMilliseconds / Bucket.Frames, Bucket.PeakNetcodeMilliseconds);
+	}
+
+	const bool bSaved = FFileHelper::SaveStringToFile(Csv, *FilePath);
+
+	UE_LOG(LogWesternWar, Log, TEXT("Server Load | %s %s"), bSaved ? TEXT("Exported to") : TEXT("Failed to export to"), *FilePath);
+
+	return bSaved;
+}
+
+FString FServerLoadStats::GetSessionCsvPath()
+{
+	return FPaths::GameSavedDir() / TEXT("NetStats") / FString::Printf(TEXT("ServerLoad-%s.csv"), *FDateTime::Now().ToString());
+}
@@ -0,0 +1,39 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#pragma once
+
+struct FServerLoadBucket
+{
+	int32 Frames = 0;
+	double TotalGameThreadMilliseconds = 0;
+	float PeakGameThreadMilliseconds = 0;
+	double TotalNetcodeMilliseconds = 0;
+	float PeakNetcodeMilliseconds = 0;
+};
+
+/*
+* Server Load Stats - Server frame time against the number of connected players
+* - Every server frame is added to the bucket of the player count at that moment
+* - The game thread time is the server tick of the game state (snapshot history, melee swings, killcam), timed directly
+*   so it is also measured on a dedicated server
+* - Logged with ww.ServerLoad, written to Saved/NetStats as CSV at the end of every session (ww.NetStats.AutoExport)
+*/
+class WESTERNWAR_API FServerLoadStats
+{
+private:
+	TMap<int32, FServerLoadBucket> Buckets;
+
+public:
+	static FServerLoadStats& Get();
+
+	void RecordFrame(int32 NumPlayers, float GameThreadMilliseconds, float NetcodeMilliseconds);
+	void Reset();
+
+	bool HasFrames() const { return Buckets.Num() > 0; }
+
+	void LogStats() const;
+	bool ExportCsv(const FString& FilePath) const;
+
+	//Saved/NetStats/ServerLoad-<Date>.csv
+	static FString GetSessionCsvPath();
+};
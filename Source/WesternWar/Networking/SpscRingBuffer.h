@@ -0,0 +1,95 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#pragma once
+
+/*
+* SPSC Ring Buffer - lock free single producer / single consumer queue with a capacity fixed at compile time
+* - The producer only writes Tail & the consumer only writes Head, a memory barrier orders the element against the index
+* - Nothing is allocated after construction, a full ring refuses new elements instead of growing
+* - Only one thread may enqueue & only one thread may dequeue, they may be the same thread
+*/
+template <typename ElementType, uint32 Capacity>
+class TSpscRingBuffer
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SPSC ring buffer capacity must be a power of two");
+
+private:
+	ElementType Elements[Capacity];
+
+	volatile uint32 Head = 0;	//Next element to dequeue, written by the consumer
+	volatile uint32 Tail = 0;	//Next free element, written by the producer
+
+public:
+	//Producer - false if the ring is full
+	bool Enqueue(const ElementType& Element)
+	{
+		const uint32 CurrentTail = Tail;
+
+		if (CurrentTail - Head >= Capacity)
+		{
+			return false;
+		}
+
+		Elements[CurrentTail & (Capacity - 1)] = Element;
+
+		FPlatformMisc::MemoryBarrier();
+		Tail = CurrentTail + 1;
+
+		return true;
+	}
+
+	//Consumer
+	bool Peek(ElementType& OutElement) const
+	{
+		const uint32 CurrentHead = Head;
+
+		if (CurrentHead == Tail)
+		{
+			return false;
+		}
+
+		FPlatformMisc::MemoryBarrier();
+		OutElement = Elements[CurrentHead & (Capacity - 1)];
+
+		return true;
+	}
+
+	//Consumer
+	bool Dequeue(ElementType& OutElement)
+	{
+		if (!Peek(OutElement))
+		{
+			return false;
+		}
+
+		FPlatformMisc::MemoryBarrier();
+		Head = Head + 1;
+
+		return true;
+	}
+
+	//Consumer
+	bool Pop()
+	{
+		if (Head == Tail)
+		{
+			return false;
+		}
+
+		FPlatformMisc::MemoryBarrier();
+		Head = Head + 1;
+
+		return true;
+	}
+
+	//Consumer - drops every element enqueued so far
+	void Empty()
+	{
+		FPlatformMisc::MemoryBarrier();
+		Head = Tail;
+	}
+
+	bool IsEmpty() const { return Head == Tail; }
+	int32 Num() const { return (int32)(Tail - Head); }
+	static int32 GetCapacity() { return Capacity; }
+};
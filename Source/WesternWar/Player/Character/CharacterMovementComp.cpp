@@ -3,6 +3,263 @@
 #include "WesternWar.h"
 #include "CharacterMovementComp.h"
 
+bool UCharacterMovementComp::CanCombineWithPendingMove(const FClientCharacterData& NewMove, bool bStateAllowsCombining) const
+{
+	if (!bEnableMoveCombining || !bHasPendingMove || !bPendingMoveCanCombine || !bStateAllowsCombining)
+	{
+		return false;
+	}
 
+	if (PendingMove.DeltaTime + NewMove.DeltaTime > MoveHeartbeatInterval)
+	{
+		return false;
+	}
 
+	//Turning is applied once per move & jumping changes the movement state, so only plain movement is combined
+	//Vertical look input only moves the camera & is not part of the simulation
+	return NewMove.VerticalInput == PendingMove.VerticalInput
+		&& NewMove.HorizontalInput == PendingMove.HorizontalInput
+		&& NewMove.UpInput == 0 && PendingMove.UpInput == 0
+		&& NewMove.HorizontalLookInput == 0 && PendingMove.HorizontalLookInput == 0;
+}
 
+void UCharacterMovementComp::SetPendingMove(const FClientCharacterData& Move, const FVector& StartLocation, bool bCanCombine)
+{
+	PendingMove = Move;
+	PendingMoveStartLocation = StartLocation;
+	bPendingMoveCanCombine = bCanCombine;
+	bHasPendingMove = true;
+}
+
+bool UCharacterMovementComp::ShouldSendPendingMove() const
+{
+	if (!bHasPendingMove)
+	{
+		return false;
+	}
+
+	return !bEnableMoveCombining || !bPendingMoveCanCombine || PendingMove.DeltaTime >= MoveHeartbeatInterval;
+}
+
+bool UCharacterMovementComp::TakePendingMove(FClientCharacterData& OutMove)
+{
+	if (!bHasPendingMove)
+	{
+		return false;
+	}
+
+	OutMove = PendingMove;
+	bHasPendingMove = false;
+
+	return true;
+}
+
+void UCharacterMovementComp::CacheCollisionShape()
+{
+	bHasCachedCollisionShape = false;
+
+	//No collision on the updated component - moves are not swept, same as moving the component
+	if (!UpdatedPrimitive || !UpdatedPrimitive->IsCollisionEnabled())
+	{
+		return;
+	}
+
+	//Shape components (the character capsule) are swept with their own scaled shape centered on the component,
+	//any other primitive with its local space bounds box, which is rotated with the character when swept
+	if (UpdatedPrimitive->IsA(UShapeComponent::StaticClass()))
+	{
+		CachedCollisionShape = UpdatedPrimitive->GetCollisionShape();
+		CachedShapeOffset = FVector::ZeroVector;
+	}
+	else
+	{
+		const FBoxSphereBounds LocalBounds = UpdatedPrimitive->CalcBounds(FTransform(FQuat::Identity, FVector::ZeroVector, UpdatedPrimitive->GetComponentScale()));
+		CachedCollisionShape = FCollisionShape::MakeBox(LocalBounds.BoxExtent);
+		CachedShapeOffset = LocalBounds.Origin;
+	}
+
+	if (CachedCollisionShape.IsNearlyZero())
+	{
+		return;
+	}
+
+	CachedCollisionChannel = UpdatedPrimitive->GetCollisionObjectType();
+
+	CachedQueryParams = FCollisionQueryParams(FName(TEXT("KinematicMove")), false, GetOwner());
+	CachedResponseParams = FCollisionResponseParams();
+	UpdatedPrimitive->InitSweepCollisionParams(CachedQueryParams, CachedResponseParams);
+
+	bHasCachedCollisionShape = true;
+}
+
+bool UCharacterMovementComp::KinematicSweep(const FVector& Start, const FVector& Delta, const FQuat& Rotation, FHitResult& OutHit) const
+{
+	const FVector ShapeStart = Start + Rotation.RotateVector(CachedShapeOffset);
+
+	if (ReplayProxyFrame)
+	{
+		const bool bHasHit = GetWorld()->SweepSingleByChannel(OutHit, ShapeStart, ShapeStart + Delta, Rotation, CachedCollisionChannel, CachedCollisionShape, ReplayQueryParams, CachedResponseParams);
+
+		return SweepReplayProxies(ShapeStart, Delta, OutHit, bHasHit);
+	}
+
+	return GetWorld()->SweepSingleByChannel(OutHit, ShapeStart, ShapeStart + Delta, Rotation, CachedCollisionChannel, CachedCollisionShape, CachedQueryParams, CachedResponseParams);
+}
+
+void UCharacterMovementComp::SetReplayProxies(const FReplayProxyFrame& ProxyFrame)
+{
+	if (!bHasCachedCollisionShape)
+	{
+		CacheCollisionShape();
+	}
+
+	ReplayProxyFrame = &ProxyFrame;
+	ReplayQueryParams = CachedQueryParams;
+
+	for (int32 i = 0; i < ProxyFrame.NumProxies; i++)
+	{
+		const UPrimitiveComponent* ProxyComponent = ProxyFrame.Components[i].Get();
+
+		if (ProxyComponent)
+		{
+			ReplayQueryParams.AddIgnoredActor(ProxyComponent->GetOwner());
+		}
+	}
+}
+
+/*
+* Sweep against every proxy of the replay frame at its saved location
+* - The sweep is offset by how far the proxy has moved since, instead of moving the proxy back
+* - Component sweeps are not rotated, the shape is swept axis aligned against the proxies
+*/
+bool UCharacterMovementComp::SweepReplayProxies(const FVector& ShapeStart, const FVector& Delta, FHitResult& InOutHit, bool bHasHit) const
+{
+	for (int32 i = 0; i < ReplayProxyFrame->NumProxies; i++)
+	{
+		UPrimitiveComponent* ProxyComponent = ReplayProxyFrame->Components[i].Get();
+
+		if (!ProxyComponent)
+		{
+			continue;
+		}
+
+		const FVector Offset = ProxyComponent->GetComponentLocation() - ReplayProxyFrame->Locations[i];
+		FHitResult ProxyHit;
+
+		if (ProxyComponent->SweepComponent(ProxyHit, ShapeStart + Offset, ShapeStart + Delta + Offset, CachedCollisionShape) && (!bHasHit || ProxyHit.Time < InOutHit.Time))
+		{
+			ProxyHit.Location -= Offset;
+			ProxyHit.ImpactPoint -= Offset;
+			ProxyHit.TraceStart -= Offset;
+			ProxyHit.TraceEnd -= Offset;
+
+			InOutHit = ProxyHit;
+			bHasHit = true;
+		}
+	}
+
+	return bHasHit;
+}
+
+/*
+* Sweep & move the location up to the blocking hit
+* - Starting inside geometry pushes the shape out along the hit normal & sweeps again once, like SafeMoveUpdatedComponent
+*/
+bool UCharacterMovementComp::KinematicSweepAndPullBack(FVector& Location, const FVector& Delta, const FQuat& Rotation, FHitResult& OutHit) const
+{
+	if (!KinematicSweep(Location, Delta, Rotation, OutHit))
+	{
+		Location += Delta;
+		return false;
+	}
+
+	if (OutHit.bStartPenetrating)
+	{
+		Location += OutHit.Normal * (OutHit.PenetrationDepth + KINEMATIC_MOVE_PULLBACK_DISTANCE);
+
+		if (!KinematicSweep(Location, Delta, Rotation, OutHit))
+		{
+			Location += Delta;
+			return false;
+		}
+
+		//Still stuck, stay where the push out left the shape
+		if (OutHit.bStartPenetrating)
+		{
+			return true;
+		}
+	}
+
+	const float DeltaSize = Delta.Size();
+	const float PulledBackTime = FMath::Clamp(OutHit.Time - KINEMATIC_MOVE_PULLBACK_DISTANCE / FMath::Max(DeltaSize, KINDA_SMALL_NUMBER), 0.0f, 1.0f);
+
+	Location += Delta * PulledBackTime;
+
+	return true;
+}
+
+bool UCharacterMovementComp::IsMoveBlocked(const FVector& Location, const FRotator& Rotation, const FVector& Delta)
+{
+	if (!bHasCachedCollisionShape)
+	{
+		CacheCollisionShape();
+	}
+
+	if (!bHasCachedCollisionShape || Delta.IsNearlyZero())
+	{
+		return false;
+	}
+
+	FHitResult Hit;
+
+	return KinematicSweep(Location, Delta, Rotation.Quaternion(), Hit);
+}
+
+bool UCharacterMovementComp::KinematicMove(FVector& Location, const FRotator& Rotation, const FVector& Delta, FHitResult& OutHit)
+{
+	OutHit.Init();
+
+	if (Delta.IsNearlyZero())
+	{
+		return false;
+	}
+
+	if (!bHasCachedCollisionShape)
+	{
+		CacheCollisionShape();
+
+		if (!bHasCachedCollisionShape)
+		{
+			Location += Delta;
+			return false;
+		}
+	}
+
+	const FQuat Quat = Rotation.Quaternion();
+
+	if (!KinematicSweepAndPullBack(Location, Delta, Quat, OutHit))
+	{
+		return false;
+	}
+
+	//Slide along the surface for the rest of the move - same slide vector & two wall adjustment as SlideAlongSurface
+	FVector SlideDelta = ComputeSlideVector(Delta, 1.0f - OutHit.Time, OutHit.Normal, OutHit);
+
+	if ((SlideDelta | Delta) > 0.0f)
+	{
+		FHitResult SlideHit;
+
+		if (KinematicSweepAndPullBack(Location, SlideDelta, Quat, SlideHit))
+		{
+			TwoWallAdjust(SlideDelta, SlideHit, OutHit.Normal);
+
+			//Only if the new direction is long enough & not against the original move
+			if (!SlideDelta.IsNearlyZero(1e-3f) && (SlideDelta | Delta) > 0.0f)
+			{
+				KinematicSweepAndPullBack(Location, SlideDelta, Quat, SlideHit);
+			}
+		}
+	}
+
+	return true;
+}
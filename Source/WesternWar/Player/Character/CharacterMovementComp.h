@@ -3,17 +3,134 @@
 #pragma once
 
 #include "GameFramework/PawnMovementComponent.h"
+#include "CharacterNetData.h"
+#include "Networking/PredictedMovement.h"
 #include "CharacterMovementComp.generated.h"
 
+#define KINEMATIC_MOVE_PULLBACK_DISTANCE 0.125f	//Distance kept from blocking geometry, so the next sweep does not start penetrating
+#define MAX_SAVED_MOVES 128	//Over 2 seconds of unacknowledged moves at 60 fps, the oldest move is dropped when full
+#define MAX_REPLAY_PROXIES 8	//Nearby simulated proxies whose positions are saved with every move
+
+//Where the nearby simulated proxies were shown when a move was predicted
+struct FReplayProxyFrame
+{
+	int32 NumProxies = 0;
+	TWeakObjectPtr<UPrimitiveComponent> Components[MAX_REPLAY_PROXIES];
+	FVector Locations[MAX_REPLAY_PROXIES];
+};
+
+//Input of a saved move - the move as it was sent & the proxies it was predicted against
+struct FCharacterMoveInput
+{
+	FClientCharacterData Move;
+	FReplayProxyFrame ProxyFrame;
+};
+
+//Predicted result of a move, the same values the server sends back in FServerCharacterData
+struct FCharacterPredictionState
+{
+	FVector Location = FVector::ZeroVector;
+	FRotator Rotation = FRotator::ZeroRotator;
+	FCharacterMovementState MovementState;
+
+	FCharacterPredictionState() {}
+	FCharacterPredictionState(const FVector& InLocation, const FRotator& InRotation, const FCharacterMovementState& InMovementState)
+		: Location(InLocation), Rotation(InRotation), MovementState(InMovementState) {}
+};
+
+/*
+* Movement step of APlayerCharacter for TPredictedMovement, Simulate & IsWithinErrorMargin are defined with the character
+* - The state is sent at full precision & the movement state is quantized by its NetSerialize, so Quantize keeps the prediction as simulated
+*/
+struct FCharacterPredictionStep
+{
+	class APlayerCharacter* Character;
+
+	explicit FCharacterPredictionStep(APlayerCharacter* InCharacter) : Character(InCharacter) {}
+
+	static int16 GetMoveID(const FCharacterMoveInput& Input) { return Input.Move.SimulationID; }
+	void Simulate(const FCharacterMoveInput& Input, FCharacterPredictionState& State);
+	static void Quantize(FCharacterPredictionState& State) {}
+	bool IsWithinErrorMargin(const FCharacterPredictionState& Predicted, const FCharacterPredictionState& Authoritative) const;
+};
+
+typedef TPredictedMovement<FCharacterPredictionState, FCharacterMoveInput, FCharacterPredictionStep, MAX_SAVED_MOVES> FCharacterPredictedMovement;
+
 /**
- * 
+ * Saved Moves - client moves the server has not acknowledged yet, replayed in place after a correction (TPredictedMovement)
+ * - The newest move is held back as the pending move, unchanged movement input is combined into it
+ *   & only sent once the input changes or the heartbeat interval is reached
+ *
+ * Kinematic Move - movement through scene queries only
+ * - The collision shape of the updated component is cached once & swept with the given rotation, no components are moved
+ * - The caller writes the final transform back once, so replaying N moves costs N sweeps instead of N component moves
+ * - Forward prediction, rewind & replay & the server simulation all use this, so they slide the same way
+ *
+ * Replay Proxies - during replay the nearby simulated proxies collide where they were shown when the move was predicted
+ * - The live proxy components are ignored by the world sweep & swept against with the offset to their saved location,
+ *   so no proxy is moved & the physics scene is never updated
  */
 UCLASS()
 class WESTERNWAR_API UCharacterMovementComp : public UPawnMovementComponent
 {
 	GENERATED_BODY()
 	
-	
-	
+private:
+	FCollisionShape CachedCollisionShape;
+	FVector CachedShapeOffset = FVector::ZeroVector;	//Center of the shape relative to the updated component
+	ECollisionChannel CachedCollisionChannel = ECC_Pawn;
+	FCollisionQueryParams CachedQueryParams;
+	FCollisionResponseParams CachedResponseParams;
+	bool bHasCachedCollisionShape = false;
+
+	FCharacterPredictedMovement Prediction;
+
+	const FReplayProxyFrame* ReplayProxyFrame = nullptr;
+	FCollisionQueryParams ReplayQueryParams;
+
+	FClientCharacterData PendingMove;
+	FVector PendingMoveStartLocation = FVector::ZeroVector;
+	bool bHasPendingMove = false;
+	bool bPendingMoveCanCombine = false;
+
+	bool KinematicSweep(const FVector& Start, const FVector& Delta, const FQuat& Rotation, FHitResult& OutHit) const;
+	bool SweepReplayProxies(const FVector& ShapeStart, const FVector& Delta, FHitResult& InOutHit, bool bHasHit) const;
+	bool KinematicSweepAndPullBack(FVector& Location, const FVector& Delta, const FQuat& Rotation, FHitResult& OutHit) const;
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Saved Moves")
+		bool bEnableMoveCombining = true;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Saved Moves")
+		float MoveHeartbeatInterval = 0.05f;	//Longest time unchanged input is combined for before the move is sent
+
+	//Saved Moves
+	FCharacterPredictedMovement& GetPrediction() { return Prediction; }
+
+	//Kinematic moves collide with the proxies of the frame until ClearReplayProxies is called
+	void SetReplayProxies(const FReplayProxyFrame& ProxyFrame);
+	void ClearReplayProxies() { ReplayProxyFrame = nullptr; }
+
+	//Pending Move
+	bool HasPendingMove() const { return bHasPendingMove; }
+	const FClientCharacterData& GetPendingMove() const { return PendingMove; }
+	const FVector& GetPendingMoveStartLocation() const { return PendingMoveStartLocation; }
+
+	//Same movement input without look input or jumping, and the pawn is in a state where one longer move gives the same result
+	bool CanCombineWithPendingMove(const FClientCharacterData& NewMove, bool bStateAllowsCombining) const;
+
+	void SetPendingMove(const FClientCharacterData& Move, const FVector& StartLocation, bool bCanCombine);
+
+	//Moves that can not be combined are sent straight away, combinable moves once the heartbeat interval is reached
+	bool ShouldSendPendingMove() const;
+	bool TakePendingMove(FClientCharacterData& OutMove);
+
+	//Caches the collision shape of the updated component, call again if its collision changes
+	void CacheCollisionShape();
+
+	//Sweeps the cached shape from Location by Delta & slides along the first blocking surface, returns true if something was hit
+	bool KinematicMove(FVector& Location, const FRotator& Rotation, const FVector& Delta, FHitResult& OutHit);
+
+	//Single sweep of the cached shape, true if anything blocks the move
+	bool IsMoveBlocked(const FVector& Location, const FRotator& Rotation, const FVector& Delta);
 	
 };
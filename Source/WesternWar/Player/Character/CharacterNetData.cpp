@@ -0,0 +1,24 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#include "WesternWar.h"
+#include "CharacterNetData.h"
+
+bool FCharacterMovementState::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = SerializePackedVector<100, 30>(MoveDirection, Ar);
+
+	uint8 JumpTimerMilliseconds = (uint8)FMath::Clamp(FMath::RoundToInt(JumpTimer * 1000), 0, 255);
+	uint8 Flags = bCanJump ? 1 : 0;
+
+	Ar << HorizontalTurnVal;
+	Ar << JumpTimerMilliseconds;
+	Ar.SerializeBits(&Flags, 1);
+
+	if (Ar.IsLoading())
+	{
+		JumpTimer = JumpTimerMilliseconds / 1000.0f;
+		bCanJump = (Flags & 1) != 0;
+	}
+
+	return true;
+}
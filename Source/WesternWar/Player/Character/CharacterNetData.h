@@ -0,0 +1,243 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#pragma once
+
+#include "Networking/PredictedMovement.h"
+#include "CharacterNetData.generated.h"
+
+USTRUCT()
+struct FCharacterMovementState
+{
+	/*
+	* Every value the movement step reads besides the transform & the input of the move
+	* - Sent with the server results & saved with every predicted move, so a replay starts from the exact server state
+	* - NetSerialize packs the velocity to 0.01 units & the jump timer to milliseconds
+	*/
+
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY()
+		FVector MoveDirection = FVector::ZeroVector;	//Velocity of the last step, gravity accumulates into Z while airborne
+	UPROPERTY()
+		float HorizontalTurnVal = 0;
+	UPROPERTY()
+		float JumpTimer = 0;
+	UPROPERTY()
+		bool bCanJump = true;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+	//Tolerances match the precision of NetSerialize
+	bool Equals(const FCharacterMovementState& Other) const
+	{
+		return bCanJump == Other.bCanJump
+			&& FMath::Abs(JumpTimer - Other.JumpTimer) <= 0.001f
+			&& FMath::Abs(HorizontalTurnVal - Other.HorizontalTurnVal) <= 0.01f
+			&& MoveDirection.Equals(Other.MoveDirection, 0.01f);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FCharacterMovementState> : public TStructOpsTypeTraitsBase
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+USTRUCT()
+struct FClientCharacterData
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY()
+		float VerticalInput;
+	UPROPERTY()
+		float HorizontalInput;
+	UPROPERTY()
+		float UpInput;
+	UPROPERTY()
+		float VerticalLookInput;
+	UPROPERTY()
+		float HorizontalLookInput;
+
+	UPROPERTY()
+		FVector Location;
+	UPROPERTY()
+		FRotator Rotation;
+	UPROPERTY()
+		FCharacterMovementState MovementState;	//Predicted movement state after the move, compared against the server result
+
+	UPROPERTY()
+		float DeltaTime;
+	UPROPERTY()
+		int16 SimulationID;
+
+};
+
+#define MAX_CLIENT_MOVE_DELTA_TIME 1.0f	//Longer moves can only come from a broken or cheating client
+
+/*
+* Stateless sanity check of a received client move, no game state is read so it can run on any thread
+* - Non finite values would poison the server simulation & every hash & history built from it
+*/
+static FORCEINLINE bool IsValidClientMove(const FClientCharacterData& Move)
+{
+	return FMath::IsFinite(Move.VerticalInput) && FMath::IsFinite(Move.HorizontalInput) && FMath::IsFinite(Move.UpInput)
+		&& FMath::IsFinite(Move.VerticalLookInput) && FMath::IsFinite(Move.HorizontalLookInput)
+		&& !Move.Location.ContainsNaN() && !Move.Rotation.ContainsNaN()
+		&& !Move.MovementState.MoveDirection.ContainsNaN() && FMath::IsFinite(Move.MovementState.HorizontalTurnVal) && FMath::IsFinite(Move.MovementState.JumpTimer)
+		&& Move.DeltaTime >= 0 && Move.DeltaTime <= MAX_CLIENT_MOVE_DELTA_TIME
+		&& Move.SimulationID >= 0 && Move.SimulationID <= PREDICTED_MOVE_ID_RANGE;
+}
+
+USTRUCT()
+struct FServerCharacterData
+{
+	//Contains server data for the simulated character from local client input
+
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY()
+		FVector Location;
+	UPROPERTY()
+		FRotator Rotation;
+	UPROPERTY()
+		FCharacterMovementState MovementState;
+	UPROPERTY()
+		float ServerTime;
+
+	UPROPERTY()
+		int16 SimulationID;
+};
+
+#define CHARACTER_STATE_HASH_VALUES 10
+#define CHARACTER_STATE_HASH_YAW_STEPS 3600	//Yaw is quantized to 0.1 degrees & wraps around
+#define CHARACTER_STATE_HASH_BOUNDARY_TOLERANCE 0.1f	//Fraction of a step around a rounding boundary where either neighbour matches
+#define CHARACTER_STATE_HASH_MAX_AMBIGUOUS 4	//Values near a boundary tried both ways, 2^N hashes at most
+
+/*
+* Character state scaled to its quantization steps, rounding gives the quantized state
+* - Location is quantized to 0.1 units & yaw to 0.1 degrees
+* - The movement state is quantized like its NetSerialize - velocity to 0.01 units, the jump timer to clamped milliseconds
+*/
+static FORCEINLINE void GetScaledCharacterState(const FVector& Location, const FRotator& Rotation, const FCharacterMovementState& MovementState, float OutScaledState[CHARACTER_STATE_HASH_VALUES])
+{
+	OutScaledState[0] = Location.X * 10;
+	OutScaledState[1] = Location.Y * 10;
+	OutScaledState[2] = Location.Z * 10;
+	OutScaledState[3] = FRotator::ClampAxis(Rotation.Yaw) * 10;
+	OutScaledState[4] = MovementState.MoveDirection.X * 100;
+	OutScaledState[5] = MovementState.MoveDirection.Y * 100;
+	OutScaledState[6] = MovementState.MoveDirection.Z * 100;
+	OutScaledState[7] = MovementState.HorizontalTurnVal * 100;
+	OutScaledState[8] = FMath::Clamp(MovementState.JumpTimer * 1000, 0.0f, 255.0f);
+	OutScaledState[9] = MovementState.bCanJump ? 1 : 0;
+}
+
+static FORCEINLINE uint32 HashQuantizedCharacterState(int32 QuantizedState[CHARACTER_STATE_HASH_VALUES])
+{
+	QuantizedState[3] = (QuantizedState[3] % CHARACTER_STATE_HASH_YAW_STEPS + CHARACTER_STATE_HASH_YAW_STEPS) % CHARACTER_STATE_HASH_YAW_STEPS;
+
+	return FCrc::MemCrc32(QuantizedState, sizeof(int32) * CHARACTER_STATE_HASH_VALUES);
+}
+
+/*
+* Compact hash of the quantized server result, sent with move acknowledgements
+* - Checked by the owning client with MatchesCharacterStateHash, never compared directly
+*/
+static FORCEINLINE uint32 GetCharacterStateHash(const FVector& Location, const FRotator& Rotation, const FCharacterMovementState& MovementState)
+{
+	float ScaledState[CHARACTER_STATE_HASH_VALUES];
+	int32 QuantizedState[CHARACTER_STATE_HASH_VALUES];
+
+	GetScaledCharacterState(Location, Rotation, MovementState, ScaledState);
+
+	for (int32 i = 0; i < CHARACTER_STATE_HASH_VALUES; i++)
+	{
+		QuantizedState[i] = FMath::RoundToInt(ScaledState[i]);
+	}
+
+	return HashQuantizedCharacterState(QuantizedState);
+}
+
+/*
+* Does a predicted state match the hash of the server result
+* - A prediction a fraction of a step away from the server result can round the other way, so values close to a rounding
+*   boundary are tried with both neighbours & tiny divergences do not cause corrections
+*/
+static FORCEINLINE bool MatchesCharacterStateHash(const FVector& Location, const FRotator& Rotation, const FCharacterMovementState& MovementState, uint32 Hash)
+{
+	float ScaledState[CHARACTER_STATE_HASH_VALUES];
+	int32 QuantizedState[CHARACTER_STATE_HASH_VALUES];
+	int32 AmbiguousValues[CHARACTER_STATE_HASH_MAX_AMBIGUOUS];
+	int32 AmbiguousSteps[CHARACTER_STATE_HASH_MAX_AMBIGUOUS];
+	int32 NumAmbiguous = 0;
+
+	GetScaledCharacterState(Location, Rotation, MovementState, ScaledState);
+
+	for (int32 i = 0; i < CHARACTER_STATE_HASH_VALUES; i++)
+	{
+		QuantizedState[i] = FMath::RoundToInt(ScaledState[i]);
+
+		const float Fraction = ScaledState[i] - QuantizedState[i];
+
+		if (NumAmbiguous < CHARACTER_STATE_HASH_MAX_AMBIGUOUS && FMath::Abs(Fraction) >= 0.5f - CHARACTER_STATE_HASH_BOUNDARY_TOLERANCE)
+		{
+			AmbiguousValues[NumAmbiguous] = i;
+			AmbiguousSteps[NumAmbiguous] = Fraction > 0 ? 1 : -1;
+			NumAmbiguous++;
+		}
+	}
+
+	for (int32 Combination = 0; Combination < (1 << NumAmbiguous); Combination++)
+	{
+		int32 CandidateState[CHARACTER_STATE_HASH_VALUES];
+		FMemory::Memcpy(CandidateState, QuantizedState, sizeof(CandidateState));
+
+		for (int32 i = 0; i < NumAmbiguous; i++)
+		{
+			if (Combination & (1 << i))
+			{
+				CandidateState[AmbiguousValues[i]] += AmbiguousSteps[i];
+			}
+		}
+
+		if (HashQuantizedCharacterState(CandidateState) == Hash)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+USTRUCT()
+struct FInterpolationData
+{
+	//Contains server data for the simulated character from local client input thats required for interpolation on clients
+
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY()
+		FVector Location;
+	UPROPERTY()
+		FRotator Rotation;
+	UPROPERTY()
+		float ServerTime;
+	UPROPERTY()
+		int16 SimulationID = 0;
+	UPROPERTY()
+		bool bIsEmpty = true;
+
+	static FInterpolationData Lerp(FInterpolationData FromData, FInterpolationData ToData, float Step)
+	{
+		FInterpolationData Result;
+
+		Result.Location = FMath::Lerp(FromData.Location, ToData.Location, Step);
+		Result.Rotation = FMath::Lerp(FromData.Rotation, ToData.Rotation, Step);
+
+		return Result;
+	}
+};
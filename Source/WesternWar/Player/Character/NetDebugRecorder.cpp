@@ -0,0 +1,102 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#include "WesternWar.h"
+#include "NetDebugRecorder.h"
+
+#if WW_NETCODE_DEBUG
+
+FNetDebugRecorder::FNetDebugRecorder()
+{
+	Reset();
+}
+
+void FNetDebugRecorder::Record(ENetDebugSample::Type Type, const FVector& Location, float Time)
+{
+	FNetDebugSample& Sample = Samples[Head];
+	Sample.Location = Location;
+	Sample.Time = Time;
+	Sample.Type = Type;
+	Sample.bStartsNewLine = bStartNewLine[Type];
+
+	bStartNewLine[Type] = false;
+
+	Head = (Head + 1) % NET_DEBUG_RECORDER_CAPACITY;
+	NumSamples = FMath::Min(NumSamples + 1, NET_DEBUG_RECORDER_CAPACITY);
+}
+
+void FNetDebugRecorder::BreakLine(ENetDebugSample::Type Type)
+{
+	bStartNewLine[Type] = true;
+}
+
+void FNetDebugRecorder::Draw(UWorld* World, float VisibleTimeWindow, float HeightOffset)
+{
+	if (!World || !World->LineBatcher || NumSamples == 0)
+	{
+		return;
+	}
+
+	static const FLinearColor Colors[ENetDebugSample::Count] =
+	{
+		FLinearColor(FColor::Green),
+		FLinearColor(FColor::Yellow),
+		FLinearColor(FColor::Blue),
+		FLinearColor(FColor::Black),
+		FLinearColor(FColor::Red),
+	};
+
+	ULineBatchComponent* LineBatcher = World->LineBatcher;
+	const float LifeTime = LineBatcher->DefaultLifeTime;
+	const float OldestVisibleTime = World->GetTimeSeconds() - VisibleTimeWindow;
+	const FVector Offset(0, 0, HeightOffset);
+
+	FVector PreviousLocation[ENetDebugSample::Count];
+	bool bHasPreviousLocation[ENetDebugSample::Count] = { false };
+
+	LineBatch.Reset();
+
+	//Oldest to newest, so every sample can be connected to the previous sample of its type
+	for (int32 i = 0; i < NumSamples; i++)
+	{
+		const FNetDebugSample& Sample = Samples[(Head - NumSamples + i + NET_DEBUG_RECORDER_CAPACITY) % NET_DEBUG_RECORDER_CAPACITY];
+
+		if (Sample.Time < OldestVisibleTime)
+		{
+			continue;
+		}
+
+		const FVector Location = Sample.Location + Offset;
+		const bool bIsWrongPrediction = Sample.Type == ENetDebugSample::WrongPredictionServer || Sample.Type == ENetDebugSample::WrongPredictionClient;
+
+		LineBatcher->BatchedPoints.Add(FBatchedPoint(Location, Colors[Sample.Type], bIsWrongPrediction ? 30 : 5, LifeTime, SDPG_World));
+
+		if (bIsWrongPrediction)
+		{
+			continue;
+		}
+
+		if (bHasPreviousLocation[Sample.Type] && !Sample.bStartsNewLine)
+		{
+			LineBatch.Add(FBatchedLine(PreviousLocation[Sample.Type], Location, Colors[Sample.Type], LifeTime, 0.1f, SDPG_World));
+		}
+
+		PreviousLocation[Sample.Type] = Location;
+		bHasPreviousLocation[Sample.Type] = true;
+	}
+
+	LineBatcher->BatchedLines.Append(LineBatch);
+	LineBatcher->MarkRenderStateDirty();
+}
+
+void FNetDebugRecorder::Reset()
+{
+	Head = 0;
+	NumSamples = 0;
+
+	for (int32 i = 0; i < ENetDebugSample::Count; i++)
+	{
+		bStartNewLine[i] = true;
+	}
+}
+
+#endif
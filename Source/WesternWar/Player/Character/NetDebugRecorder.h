@@ -0,0 +1,60 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#pragma once
+
+namespace ENetDebugSample
+{
+	enum Type
+	{
+		Prediction,			//Client predicted location
+		ServerSimulation,	//Location received from the server
+		FixedPrediction,	//Client location after rewind & replay
+		WrongPredictionServer,	//Server location at the moment a misprediction was detected
+		WrongPredictionClient,	//Client location at the moment a misprediction was detected
+		Count,
+	};
+}
+
+#if WW_NETCODE_DEBUG
+
+#define NET_DEBUG_RECORDER_CAPACITY 1024
+
+struct FNetDebugSample
+{
+	FVector Location;
+	float Time;
+	uint8 Type;
+	bool bStartsNewLine;	//Not connected to the previous sample of the same type
+};
+
+/*
+* Net Debug Recorder - Fixed size ring buffer of netcode debug samples
+* - Recording only writes into the ring buffer, nothing is drawn until Draw is called
+* - Draw submits every sample inside the visible time window to the world line batcher in one go,
+*   so the amount of debug primitives is bounded by the ring buffer instead of growing with the frame rate
+*/
+class FNetDebugRecorder
+{
+private:
+	FNetDebugSample Samples[NET_DEBUG_RECORDER_CAPACITY];
+	int32 Head = 0;
+	int32 NumSamples = 0;
+
+	bool bStartNewLine[ENetDebugSample::Count];
+
+	TArray<FBatchedLine> LineBatch;
+
+public:
+	FNetDebugRecorder();
+
+	void Record(ENetDebugSample::Type Type, const FVector& Location, float Time);
+
+	//The next sample of the type will not be connected to the previous one
+	void BreakLine(ENetDebugSample::Type Type);
+
+	void Draw(UWorld* World, float VisibleTimeWindow, float HeightOffset);
+
+	void Reset();
+};
+
+#endif
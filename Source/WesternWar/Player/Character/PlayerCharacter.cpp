@@ -2,6 +2,16 @@
 
 #include "WesternWar.h"
 #include "PlayerCharacter.h"
+#include "Networking/NetTrafficStats.h"
+#include "Player/MainPlayerController.h"
+#include "Player/MainPlayerState.h"
+#include "GameManager/MainGameState.h"
+#include "UnrealNetwork.h"
+
+static TAutoConsoleVariable<int32> CVarTrustedMoves(
+	TEXT("ww.Net.TrustedMoves"),
+	0,
+	TEXT("Accept plain grounded client moves inside the plausibility envelope with a single sweep instead of re-simulating them. 0 - Off, 1 - On"));
 
 
 // Sets default values
@@ -22,33 +32,85 @@ APlayerCharacter::APlayerCharacter()
 	MovementComponent = CreateDefaultSubobject<UCharacterMovementComp>(TEXT("PawnMovementComp"));
 	MovementComponent->UpdatedComponent = RootMesh;
 
-	//Initialise a camera component for the character
+	//Initialise a camera component for the character - the server target never renders, so it does not get one
+	//Client builds always create it, so the default object & every blueprint based on it have the same components
+#if !UE_SERVER
 	CharacterCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("CameraComponent"));
 	CharacterCamera->AttachToComponent(PlayerMainCollision, FAttachmentTransformRules::KeepRelativeTransform);
+#endif
+
+	HitboxKernel::GetDefaultHitboxDefinitions(HitboxDefinitions);
 
 }
 
+void APlayerCharacter::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	//A client build run with -server never renders, so the spawned characters drop their camera
+#if !UE_SERVER
+	if (IsRunningDedicatedServer() && CharacterCamera)
+	{
+		CharacterCamera->DestroyComponent();
+		CharacterCamera = nullptr;
+	}
+#endif
+}
+
 // Called when the game starts or when spawned
 void APlayerCharacter::BeginPlay()
 {
 	Super::BeginPlay();
+
+	NetcodeTiming.Owner = this;
+	FNetcodeTimingStats::Get().RegisterPlayer(&NetcodeTiming);
+
+	if (FNetSessionRecorder::IsRecordingEnabled() && (Role == ROLE_AutonomousProxy || Role == ROLE_Authority))
+	{
+		SessionRecorder.StartRecording(FNetSessionRecorder::GetRecordingPath(this));
+	}
+
+	if (Role == ROLE_Authority)
+	{
+		FWorldSnapshotHistory* SnapshotHistory = AMainGameState::GetWorldSnapshotHistory(this);
+
+		if (SnapshotHistory)
+		{
+			WorldSnapshotSlot = SnapshotHistory->RegisterPawn(this);
+		}
+	}
 	
 	//If this is the local client store character data
 	if (Role == ROLE_AutonomousProxy)
 	{
 		Client_CharacterData.Location = GetActorLocation();
 		Client_CharacterData.Rotation = GetActorRotation();
+		Client_CharacterData.MovementState = GetMovementState();
 		Client_CharacterData.SimulationID = 0;
 		Client_CharacterData.DeltaTime = GetWorld()->DeltaTimeSeconds;
 
-		Client_CharacterInputDataQueue.Enqueue(Client_CharacterData);
+		FCharacterMoveInput MoveInput;
+		MoveInput.Move = Client_CharacterData;
+
+		MovementComponent->GetPrediction().SaveMove(MoveInput, FCharacterPredictionState(Client_CharacterData.Location, Client_CharacterData.Rotation, Client_CharacterData.MovementState));
 	}
-	//If this is the server, disable ticking on this class
-	else if(Role == ROLE_Authority)
+
+}
+
+void APlayerCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FNetcodeTimingStats::Get().UnregisterPlayer(&NetcodeTiming);
+	SessionRecorder.StopRecording();
+
+	FWorldSnapshotHistory* SnapshotHistory = AMainGameState::GetWorldSnapshotHistory(this);
+
+	if (SnapshotHistory && WorldSnapshotSlot != INDEX_NONE)
 	{
-		PrimaryActorTick.bCanEverTick = false;
+		SnapshotHistory->UnregisterPawn(WorldSnapshotSlot);
+		WorldSnapshotSlot = INDEX_NONE;
 	}
 
+	Super::EndPlay(EndPlayReason);
 }
 
 // Called every frame
@@ -56,32 +118,61 @@ void APlayerCharacter::Tick( float DeltaTime )
 {
 	Super::Tick( DeltaTime );
 
+	//Client only - prediction, camera, debug drawing & interpolation are compiled out of the server build
+#if !UE_SERVER
 	//If local client
 	if (Role == ROLE_AutonomousProxy && !bIsRewinding)
 	{
+		//Simulation time of this move, dilated to keep the servers input buffer at its target size
+		Client_CharacterData.DeltaTime = DeltaTime * ClientTimeDilation;
+
+		//Bot clients replace the player input with their synthetic input stream
+		AMainPlayerController* MainPlayerController = Cast<AMainPlayerController>(Controller);
+
+		if (MainPlayerController && MainPlayerController->IsBot())
+		{
+			MainPlayerController->GetBotInput(DeltaTime, Client_CharacterData);
+		}
+
 		RotateCamera();
+
+		const bool bMoveAllowsCombining = CanCombineMoveFrom(Client_CharacterData, GetActorLocation());
+		const bool bCombineWithPendingMove = MovementComponent->CanCombineWithPendingMove(Client_CharacterData, bMoveAllowsCombining);
+		FVector StartLocation = GetActorLocation();
+
+		if (bCombineWithPendingMove)
+		{
+			//Re-simulate the pending move & this frame as one longer move from where the pending move started
+			Client_CharacterData.DeltaTime += MovementComponent->GetPendingMove().DeltaTime;
+			StartLocation = MovementComponent->GetPendingMoveStartLocation();
+			SetActorLocation(StartLocation);
+		}
+		else
+		{
+			//Input changed - send the pending move as it is & start a new one with a new simulation ID
+			SendPendingMove();
+
+			SimulationID = PredictedMoveID::Next(SimulationID);
+		}
+
 		MoveCharacter(false, Client_CharacterData);
 
-		//Store current frame input data locally in a queue
-		Client_CharacterInputDataQueue.Enqueue(Client_CharacterData);
-		//Send current frame input data to the server
-		Server_SendClientCharacterData(Client_CharacterData);
+		MovementComponent->SetPendingMove(Client_CharacterData, StartLocation, bMoveAllowsCombining);
+
+		if (MovementComponent->ShouldSendPendingMove())
+		{
+			SendPendingMove();
+		}
 
 		//GEngine->AddOnScreenDebugMessage(-1, -1, FColor::Green, "Called Tick Local");
 
 		//DEBUG ONLY
-		if (bEnableDebug)
+		if (bEnablePredictionHistory)
 		{
-			if (bEnablePredictionHistory)
-			{
-				DisplayClientPredictionsHistory();
-			}
-
-			if (bEnableServerSimulationHistory)
-			{
-				DisplayServerSimulationsHistory();
-			}
+			RecordNetDebugSample(ENetDebugSample::Prediction, GetActorLocation());
 		}
+
+		DrawNetDebugHistory();
 	}
 
 	//If non-local client & interpolation is enabled
@@ -90,6 +181,13 @@ void APlayerCharacter::Tick( float DeltaTime )
 		InterpolateMovementData();
 		//GEngine->AddOnScreenDebugMessage(-1, -1, FColor::Red, "Interpolation Running");
 	}
+#endif
+
+	//If server, simulate the buffered client moves
+	if (Role == ROLE_Authority)
+	{
+		ConsumeServerInputBuffer(DeltaTime);
+	}
 
 }
 
@@ -98,11 +196,14 @@ void APlayerCharacter::SetupPlayerInputComponent(class UInputComponent* InputCom
 {
 	Super::SetupPlayerInputComponent(InputComponent);
 
+	//Input only comes from local players, the server receives it through Server_SendClientCharacterData
+#if !UE_SERVER
 	InputComponent->BindAxis("VerticalMovement", this, &APlayerCharacter::VerticalMovementInput);
 	InputComponent->BindAxis("HorizontalMovement", this, &APlayerCharacter::HorizontalMovementInput);
 	InputComponent->BindAxis("UpMovement", this, &APlayerCharacter::UpMovementInput);
 	InputComponent->BindAxis("VerticalLook", this, &APlayerCharacter::VerticalLookInput);
 	InputComponent->BindAxis("HorizontalLook", this, &APlayerCharacter::HorizontalLookInput);
+#endif
 
 }
 
@@ -145,31 +246,25 @@ void APlayerCharacter::HorizontalLookInput(float val)
 */
 void APlayerCharacter::MoveCharacter(bool bIsServerSide, FClientCharacterData CharacterData)
 {
-	//Time passed between the last and current frame
-	Client_CharacterData.DeltaTime = GetWorld()->DeltaTimeSeconds;
-	float DeltaSeconds = CharacterData.DeltaTime;
+	SCOPE_NETCODE_TIMER(STAT_MoveCharacter, &NetcodeTiming);
 
-	FHitResult Hit;
+	FVector Location = GetActorLocation();
+	FRotator Rotation = GetActorRotation();
 
-	//Get the direction of the movement, which is based on the user input
-	FVector MoveDirectionVector = GetMoveDirection(CharacterData) * DeltaSeconds;
+	if (!bIsServerSide || !SimulateTrustedMove(CharacterData, Location, Rotation))
+	{
+		SimulateMove(CharacterData, Location, Rotation);
 
-	//Set rotation of the character before moving
-	SetLookRotation(CharacterData);	
+		if (bIsServerSide)
+		{
+			INC_DWORD_STAT(STAT_NetcodeSimulatedMoves);
+		}
+	}
 
-	//Move the character
-	MovementComponent->SafeMoveUpdatedComponent(MoveDirectionVector,GetActorRotation(),true, Hit, ETeleportType::None);
-	MovementComponent->SlideAlongSurface(MoveDirectionVector, 1.0f, Hit.Normal, Hit, false);
+	SetActorLocationAndRotation(Location, Rotation);
 
 	if (!bIsServerSide)
 	{
-		//Increment the simulation ID, if too large, reset to 0
-		if (SimulationID >= 400)
-		{
-			SimulationID = 0;
-		}
-		SimulationID++;
-
 		Client_CharacterData.Location = GetActorLocation();
 		Client_CharacterData.Rotation = GetActorRotation();
 		Client_CharacterData.SimulationID = SimulationID;
@@ -183,11 +278,13 @@ void APlayerCharacter::MoveCharacter(bool bIsServerSide, FClientCharacterData Ch
 		CharacterSimulatedData.Location = GetActorLocation();
 		CharacterSimulatedData.Rotation = GetActorRotation();
 		CharacterSimulatedData.SimulationID = Server_CharacterData.SimulationID;
-		CharacterSimulatedData.HorizontalCharacterTurnVal = HorizontalPlayerTurnVal;
+		CharacterSimulatedData.MovementState = GetMovementState();
 		CharacterSimulatedData.ServerTime = GetWorld()->RealTimeSeconds;
 
-		//Add the character simulated data to the server history (for Lag Compensation)
-		Server_CharacterDataHistory.Add(CharacterSimulatedData.SimulationID, CharacterSimulatedData);
+		SessionRecorder.RecordServerSnapshot(CharacterSimulatedData, GetWorld()->GetTimeSeconds());
+
+		//Other clients receive the result through property replication (skips the owner)
+		ReplicatedCharacterData = CharacterSimulatedData;
 
 		ServerSimulationSteps++;
 
@@ -195,16 +292,60 @@ void APlayerCharacter::MoveCharacter(bool bIsServerSide, FClientCharacterData Ch
 		* Had a bug where server called this function twice in a very short time
 		* - May be to do with that I call this function from the client directly at every packet 
 		*   the server receives 
+		* 
+		* Owning client
+		* - Prediction matches the server result - only the simulation ID & a hash of the server result is sent
+		* - Prediction is wrong - the full server result is sent so the client can rewind & replay
 		*/
-		if (ServerSimulationSteps == FMath::Round(60/NetUpdateFrequency))
+		AMainPlayerState* MainPlayerState = GetMainPlayerState();
+		const float OwnerUpdateRate = NetUpdateFrequency * (MainPlayerState ? MainPlayerState->OwnerUpdateRateScale : 1);
+
+		if (ServerSimulationSteps >= FMath::Round(60/OwnerUpdateRate))
 		{
 			ServerSimulationSteps = 0;
-			MultiCastClient_ReplicatePawnToClients(CharacterSimulatedData);
+
+			//A client that could not match the acknowledgement hash gets the full server result, even if its last move looks correct
+			const bool bIsPredictionCorrect = !bIsCorrectionRequested && IsPredictionWithinErrorMargin(Server_CharacterData, CharacterSimulatedData);
+			bIsCorrectionRequested = false;
+
+			if (MainPlayerState)
+			{
+				MainPlayerState->RecordMoveResult(!bIsPredictionCorrect);
+			}
+
+			if (bIsPredictionCorrect)
+			{
+				Client_AcknowledgeMove(CharacterSimulatedData.SimulationID, GetCharacterStateHash(CharacterSimulatedData.Location, CharacterSimulatedData.Rotation, CharacterSimulatedData.MovementState), GetInputBufferError());
+				FNetTrafficStats::Get().RecordRpcSent(ENetRpc::Client_AcknowledgeMove, 16 + 32 + 8);
+			}
+			else
+			{
+				Client_CorrectMove(CharacterSimulatedData, GetInputBufferError());
+				FNetTrafficStats::Get().RecordRpcSent(ENetRpc::Client_CorrectMove, FNetTrafficStats::GetSerializedBits(CharacterSimulatedData) + 8);
+			}
 		}
 	}
 
 }
 
+/*
+* Run one step of the movement simulation from the input of the move
+* - Only the passed in location & rotation are changed, no components are moved (the caller writes the result back)
+*/
+void APlayerCharacter::SimulateMove(FClientCharacterData CharacterData, FVector& Location, FRotator& Rotation)
+{
+	FHitResult Hit;
+
+	//Get the direction of the movement, which is based on the user input
+	FVector MoveDirectionVector = GetMoveDirection(CharacterData, Location, Rotation) * CharacterData.DeltaTime;
+
+	//Set rotation of the character before moving
+	SetLookRotation(CharacterData, Rotation);
+
+	//Sweep the character & slide along anything it hits
+	MovementComponent->KinematicMove(Location, Rotation, MoveDirectionVector, Hit);
+}
+
 /*
 * Rotate Camera - Rotates the character attached camera
 * Rotates the camera around the x axis
@@ -215,7 +356,11 @@ void APlayerCharacter::RotateCamera()
 
 	//Clamp the max and min angle for the camera look
 	VerticalCameraTurnVal = FMath::Clamp(VerticalCameraTurnVal, MinAngle, MaxAngle);
-	CharacterCamera->SetRelativeRotation(FRotator(VerticalCameraTurnVal, 0, 0));
+
+	if (CharacterCamera)
+	{
+		CharacterCamera->SetRelativeRotation(FRotator(VerticalCameraTurnVal, 0, 0));
+	}
 }
 
 //Once a packet is received from the server, data for interpolation is added & queued
@@ -225,13 +370,21 @@ void APlayerCharacter::AddInterpolationData(FServerCharacterData ServerData)
 	TempInterData.Location = ServerData.Location;
 	TempInterData.Rotation = ServerData.Rotation;
 	TempInterData.ServerTime = ServerData.ServerTime;
+	TempInterData.SimulationID = ServerData.SimulationID;
 
-	InterpolationDataQueue.Enqueue(TempInterData);
+	//A full buffer means the proxy is not being interpolated, the newest state is dropped
+	if (!InterpolationDataQueue.Enqueue(TempInterData))
+	{
+		return;
+	}
 
 	InterpolationDataReceived++;
 
-	//Used for the first time a player joins, 2 queued data sets are required for interpolation to work
-	if (InterpolationDataReceived >= 2)
+	//Used when a player joins & after every underrun, 2 queued data sets are required for interpolation to work
+	//More are buffered when the local players connection is jittery or loses packets
+	AMainPlayerState* LocalPlayerState = GetLocalMainPlayerState();
+
+	if (InterpolationDataReceived >= (LocalPlayerState ? LocalPlayerState->GetInterpolationBufferSize(NetUpdateFrequency) : 2))
 	{
 		bCanInterpolateData = true;
 	}
@@ -239,12 +392,51 @@ void APlayerCharacter::AddInterpolationData(FServerCharacterData ServerData)
 	//GEngine->AddOnScreenDebugMessage(-1, 0.2f, FColor::Red, "Added Data");
 }
 
+void APlayerCharacter::ResetInterpolation()
+{
+	InterpolationDataQueue.Empty();
+	InterpolationDataReceived = 0;
+	bCanInterpolateData = false;
+	bIsFirstTimeInterpolation = true;
+	bCanStartNewInterpolationSet = true;
+	Step = 0;
+}
+
+void APlayerCharacter::BeginKillcamPlayback()
+{
+	if (Role == ROLE_SimulatedProxy)
+	{
+		ResetInterpolation();
+		bIsPlayingKillcam = true;
+	}
+}
+
+void APlayerCharacter::SetKillcamPose(const FVector& Location, const FRotator& Rotation)
+{
+	if (bIsPlayingKillcam)
+	{
+		SetActorLocationAndRotation(Location, Rotation);
+	}
+}
+
+//The next replicated updates refill the interpolation buffer from the live state
+void APlayerCharacter::EndKillcamPlayback()
+{
+	if (bIsPlayingKillcam)
+	{
+		ResetInterpolation();
+		bIsPlayingKillcam = false;
+	}
+}
+
 /*
 * Interpolate between received locations and positions from the server simulations
 * - Fixes jitter that is caused by low frequency network updates
 */
 void APlayerCharacter::InterpolateMovementData()
 {
+	SCOPE_NETCODE_TIMER(STAT_InterpolateMovementData, &NetcodeTiming);
+
 	if (bCanStartNewInterpolationSet)
 	{
 		if (!bIsFirstTimeInterpolation)
@@ -257,15 +449,27 @@ void APlayerCharacter::InterpolateMovementData()
 			bIsFirstTimeInterpolation = false;
 		}
 
-		InterpolationDataQueue.Dequeue(TargetInterpolationData);
+		//Buffer ran dry, hold at the last target until the buffer is back at its target depth
+		//Resuming on the next single update would run dry again at every late packet
+		if (!InterpolationDataQueue.Dequeue(TargetInterpolationData))
+		{
+			FNetTrafficStats::Get().RecordInterpolationUnderrun();
+
+			InterpolationDataReceived = 0;
+			bCanInterpolateData = false;
+			return;
+		}
+
 		bCanStartNewInterpolationSet = false;
 		Step = 0;
 
+#if WW_NETCODE_DEBUG
 		if (bEnableInterpolationTargets && bEnableDebug)
 		{
 			DrawDebugSphere(GetWorld(), PreviousInterpolationData.Location, 15, 16, FColor().Green, false, 1/NetUpdateFrequency, 2);
 			DrawDebugSphere(GetWorld(), TargetInterpolationData.Location, 15, 16, FColor().Red, false, 1/NetUpdateFrequency * 2, 2);
 		}
+#endif
 	}
 
 	if (!bCanStartNewInterpolationSet)
@@ -289,115 +493,248 @@ void APlayerCharacter::InterpolateMovementData()
 
 void APlayerCharacter::CompareServerToClientSimulationResults()
 {
-	FClientCharacterData CharacterData;
-	Client_CharacterInputDataQueue.Dequeue(CharacterData);
+	SCOPE_NETCODE_TIMER(STAT_CompareServerToClientSimulationResults, &NetcodeTiming);
+
+	FCharacterPredictedMovement::FSavedMove AcknowledgedMove;
 
-	while (CharacterData.SimulationID != CharacterSimulatedData.SimulationID)
+	//Prediction is no longer stored (already corrected), nothing to compare against
+	if (!MovementComponent->GetPrediction().AcknowledgeMove(CharacterSimulatedData.SimulationID, AcknowledgedMove))
 	{
-		Client_CharacterInputDataQueue.Dequeue(CharacterData);
+		return;
 	}
 
-	//Check distance between server and client character location, if difference is too large rewind and replay the simulation on local client
-	// - We assume server is always correct 
-	if (FVector::Dist(CharacterData.Location, CharacterSimulatedData.Location) > MaxLocationErrorMargin)
+	const FCharacterPredictionStep PredictionStep(this);
+	const FCharacterPredictionState ServerState(CharacterSimulatedData.Location, CharacterSimulatedData.Rotation, CharacterSimulatedData.MovementState);
+
+	//One replay from the full server state, however many values were wrong
+	if (!PredictionStep.IsWithinErrorMargin(AcknowledgedMove.State, ServerState))
 	{
-		DisplayWrongPredictionMoment(CharacterSimulatedData.Location);
+		RecordNetDebugSample(ENetDebugSample::WrongPredictionServer, CharacterSimulatedData.Location);
+		RecordNetDebugSample(ENetDebugSample::WrongPredictionClient, GetActorLocation());
 		RewindAndReplay();
-		//GEngine->AddOnScreenDebugMessage(-1, 0.2f, FColor::Red, "Location Wrong");
 	}
+}
+
+FCharacterMovementState APlayerCharacter::GetMovementState() const
+{
+	FCharacterMovementState MovementState;
+	MovementState.MoveDirection = MoveDirection;
+	MovementState.HorizontalTurnVal = HorizontalPlayerTurnVal;
+	MovementState.JumpTimer = JumpTimer;
+	MovementState.bCanJump = CanJump;
 
-	float TempClientRot = CharacterData.Rotation.Yaw;
-	float TempServerRot = CharacterSimulatedData.Rotation.Yaw;
+	return MovementState;
+}
 
-	if (TempClientRot < 0)
+void APlayerCharacter::SetMovementState(const FCharacterMovementState& MovementState)
+{
+	MoveDirection = MovementState.MoveDirection;
+	HorizontalPlayerTurnVal = MovementState.HorizontalTurnVal;
+	JumpTimer = MovementState.JumpTimer;
+	CanJump = MovementState.bCanJump;
+}
+
+bool APlayerCharacter::IsPredictionWithinErrorMargin(const FClientCharacterData& Prediction, const FServerCharacterData& ServerData) const
+{
+	if (FVector::Dist(Prediction.Location, ServerData.Location) > MaxLocationErrorMargin)
 	{
-		TempClientRot = 360 + TempClientRot;
+		return false;
 	}
 
-	if (TempServerRot < 0)
+	if (FMath::Abs(FRotator::NormalizeAxis(Prediction.Rotation.Yaw - ServerData.Rotation.Yaw)) >= MaxRotationErrorMargin)
 	{
-		TempServerRot = 360 + TempServerRot;
+		return false;
 	}
 
-	if (FMath::Abs(TempClientRot - TempServerRot) >= MaxRotationErrorMargin)
+	//A matching transform with a different velocity or jump state diverges on the next move
+	return Prediction.MovementState.Equals(ServerData.MovementState);
+}
+
+//Store the pending move as a saved move & send it to the server for simulation
+void APlayerCharacter::SendPendingMove()
+{
+	FClientCharacterData Move;
+
+	if (!MovementComponent->TakePendingMove(Move))
 	{
-		DisplayWrongPredictionMoment(CharacterSimulatedData.Location);
-		RewindAndReplay();
-		//GEngine->AddOnScreenDebugMessage(-1, 0.2f, FColor::Red, "Rotation Wrong");
-		//GEngine->AddOnScreenDebugMessage(-1, 0.2f, FColor::Blue, "Rotation Wrong - Client -" + FString::SanitizeFloat(TempClientRot));
-		//GEngine->AddOnScreenDebugMessage(-1, 0.2f, FColor::Green, "Rotation Wrong - Server - " + FString::SanitizeFloat(TempServerRot));
+		return;
+	}
+
+	//The pending move is only taken once it is fully simulated, so the current state is the state after it
+	Move.MovementState = GetMovementState();
+
+	FCharacterMoveInput MoveInput;
+	MoveInput.Move = Move;
+	GatherReplayProxies(MoveInput.ProxyFrame);
+
+	MovementComponent->GetPrediction().SaveMove(MoveInput, FCharacterPredictionState(Move.Location, Move.Rotation, Move.MovementState));
+	SessionRecorder.RecordClientMove(Move, GetWorld()->GetTimeSeconds());
+
+	AMainPlayerState* MainPlayerState = GetMainPlayerState();
+	const int32 InputRedundancy = MainPlayerState ? MainPlayerState->InputRedundancy : 0;
+
+	//Oldest first, so the server can simulate them in order if the original packets were lost
+	TArray<FClientCharacterData> RedundantMoves;
+
+	for (int32 i = FMath::Max(RecentSentMoves.Num() - InputRedundancy, 0); i < RecentSentMoves.Num(); i++)
+	{
+		RedundantMoves.Add(RecentSentMoves[i]);
 	}
+
+	Server_SendClientCharacterData(Move, RedundantMoves);
+	FNetTrafficStats::Get().RecordRpcSent(ENetRpc::Server_SendClientCharacterData, FNetTrafficStats::GetSerializedBits(Move) + FNetTrafficStats::GetSerializedBits(RedundantMoves));
+
+	RecentSentMoves.Add(Move);
+
+	if (RecentSentMoves.Num() > MAX_INPUT_REDUNDANCY)
+	{
+		RecentSentMoves.RemoveAt(0);
+	}
+}
+
+AMainPlayerState* APlayerCharacter::GetMainPlayerState() const
+{
+	return Cast<AMainPlayerState>(PlayerState);
+}
+
+//Player state of the player on this machine, used by the simulated proxies it sees
+AMainPlayerState* APlayerCharacter::GetLocalMainPlayerState() const
+{
+	APlayerController* LocalPlayerController = GetWorld()->GetFirstPlayerController();
+
+	return LocalPlayerController ? Cast<AMainPlayerState>(LocalPlayerController->PlayerState) : nullptr;
 }
 
 void APlayerCharacter::RewindAndReplay()
 {
+	SCOPE_NETCODE_TIMER(STAT_RewindAndReplay, &NetcodeTiming);
+
 	bIsRewinding = true;
 
-	TQueue<FClientCharacterData, EQueueMode::Mpsc> TempClientCharacterDataQueue;
-	FClientCharacterData CharacterData;
+	FCharacterPredictedMovement& Prediction = MovementComponent->GetPrediction();
+	FCharacterPredictionStep PredictionStep(this);
 
-	FClientCharacterData TempData;
-	FVector PreviousLocation = FVector::ZeroVector;
-	FRotator PreviousRotation = FRotator::ZeroRotator;
+	//Replay from the full server result, the components are only moved once with the final replayed state
+	FCharacterPredictionState State(CharacterSimulatedData.Location, CharacterSimulatedData.Rotation, CharacterSimulatedData.MovementState);
+	SetMovementState(State.MovementState);
 
-	SetActorLocation(CharacterSimulatedData.Location);
-	SetActorRotation(CharacterSimulatedData.Rotation);
-	HorizontalPlayerTurnVal = CharacterSimulatedData.HorizontalCharacterTurnVal;
+	BreakNetDebugLine(ENetDebugSample::FixedPrediction);
 
-	while (Client_CharacterInputDataQueue.Dequeue(CharacterData))
-	{
+	//Saved moves are replayed in place, the new predictions overwrite the old ones
+	int32 ReplayDepth = Prediction.Replay(PredictionStep, State);
 
-		TempData = CharacterData;
-		if (PreviousLocation == FVector::ZeroVector)
-		{
-			TempData.Location = CharacterSimulatedData.Location;
-			TempData.Rotation = CharacterSimulatedData.Rotation;
-		}
-		else
+	if (bEnableFixedPredictionHistory)
+	{
+		for (int32 i = 0; i < Prediction.GetNumSavedMoves(); i++)
 		{
-			TempData.Location = PreviousLocation;
-			TempData.Rotation = PreviousRotation;
+			RecordNetDebugSample(ENetDebugSample::FixedPrediction, Prediction.GetSavedMove(i).State.Location);
 		}
+	}
+
+	//The pending move is predicted against the proxies where they are shown now
+	MovementComponent->ClearReplayProxies();
 
-		FHitResult Hit;
-		FVector MoveVector = GetMoveDirection(TempData) * TempData.DeltaTime;
+	FClientCharacterData CharacterData;
+	FVector Location = State.Location;
+	FRotator Rotation = State.Rotation;
 
-		SetLookRotation(TempData);
-		MovementComponent->SafeMoveUpdatedComponent(MoveVector, GetActorRotation(), true, Hit, ETeleportType::None);
-		
-		CharacterData.Location = GetActorLocation();
-		CharacterData.Rotation = GetActorRotation();
+	//The unsent pending move starts where the replay ended
+	if (MovementComponent->HasPendingMove())
+	{
+		const FVector PendingStartLocation = Location;
+		CharacterData = MovementComponent->GetPendingMove();
 
-		TempClientCharacterDataQueue.Enqueue(CharacterData);
+		//Same rule as when the move was first predicted, evaluated in the replayed state before the move
+		const bool bMoveAllowsCombining = CanCombineMoveFrom(CharacterData, PendingStartLocation);
 
-		PreviousLocation = CharacterData.Location;
-		PreviousRotation = CharacterData.Rotation;
+		SimulateMove(CharacterData, Location, Rotation);
 
-		if (bEnableFixedPredictionHistory)
-		{
-			DisplayFixedPredictionsHistory(CharacterData.Location);
-		}
+		CharacterData.Location = Location;
+		CharacterData.Rotation = Rotation;
+
+		MovementComponent->SetPendingMove(CharacterData, PendingStartLocation, bMoveAllowsCombining);
+		ReplayDepth++;
 	}
 
-	Debug_LastFixedLocation = FVector::ZeroVector;
+	SetActorLocationAndRotation(Location, Rotation);
+
+	FNetTrafficStats::Get().RecordReplay(ReplayDepth);
+
+	bIsRewinding = false;
 
-	Client_CharacterInputDataQueue.Empty();
+}
 
-	while (TempClientCharacterDataQueue.Dequeue(CharacterData))
+//One replayed move - collides with the proxies where they were shown when the move was predicted
+void FCharacterPredictionStep::Simulate(const FCharacterMoveInput& Input, FCharacterPredictionState& State)
+{
+	Character->MovementComponent->SetReplayProxies(Input.ProxyFrame);
+	Character->SetMovementState(State.MovementState);
+	Character->SimulateMove(Input.Move, State.Location, State.Rotation);
+
+	State.MovementState = Character->GetMovementState();
+}
+
+//Client side check of an acknowledged prediction, every wrong value is counted as a misprediction cause
+bool FCharacterPredictionStep::IsWithinErrorMargin(const FCharacterPredictionState& Predicted, const FCharacterPredictionState& Authoritative) const
+{
+	bool bIsMispredicted = false;
+
+	if (FVector::Dist(Predicted.Location, Authoritative.Location) > Character->MaxLocationErrorMargin)
 	{
-		Client_CharacterInputDataQueue.Enqueue(CharacterData);
+		FNetTrafficStats::Get().RecordMisprediction(ENetMispredictionCause::Location);
+		bIsMispredicted = true;
 	}
 
-	bIsRewinding = false;
+	if (FMath::Abs(FRotator::NormalizeAxis(Predicted.Rotation.Yaw - Authoritative.Rotation.Yaw)) >= Character->MaxRotationErrorMargin)
+	{
+		FNetTrafficStats::Get().RecordMisprediction(ENetMispredictionCause::Rotation);
+		bIsMispredicted = true;
+	}
+
+	//Same transform but a different velocity or jump state diverges on the next moves
+	if (!bIsMispredicted && !Predicted.MovementState.Equals(Authoritative.MovementState))
+	{
+		FNetTrafficStats::Get().RecordMisprediction(ENetMispredictionCause::MovementState);
+		bIsMispredicted = true;
+	}
+
+	return !bIsMispredicted;
+}
+
+void APlayerCharacter::GatherReplayProxies(FReplayProxyFrame& OutProxyFrame)
+{
+	if (CachedReplayProxyFrameNumber != GFrameCounter)
+	{
+		CachedReplayProxyFrameNumber = GFrameCounter;
+		CachedReplayProxyFrame.NumProxies = 0;
+
+		const float ReplayProxyRadiusSquared = FMath::Square(ReplayProxyRadius);
+
+		for (TActorIterator<APlayerCharacter> It(GetWorld()); It && CachedReplayProxyFrame.NumProxies < MAX_REPLAY_PROXIES; ++It)
+		{
+			const APlayerCharacter* Proxy = *It;
+			UPrimitiveComponent* ProxyComponent = Proxy->MovementComponent ? Proxy->MovementComponent->UpdatedPrimitive : nullptr;
+
+			if (Proxy->Role == ROLE_SimulatedProxy && ProxyComponent && FVector::DistSquared(Proxy->GetActorLocation(), GetActorLocation()) <= ReplayProxyRadiusSquared)
+			{
+				CachedReplayProxyFrame.Components[CachedReplayProxyFrame.NumProxies] = ProxyComponent;
+				CachedReplayProxyFrame.Locations[CachedReplayProxyFrame.NumProxies] = ProxyComponent->GetComponentLocation();
+				CachedReplayProxyFrame.NumProxies++;
+			}
+		}
+	}
 
+	OutProxyFrame = CachedReplayProxyFrame;
 }
 
 //Get the direction the player should move in
-FVector APlayerCharacter::GetMoveDirection(FClientCharacterData CharacterData)
+FVector APlayerCharacter::GetMoveDirection(FClientCharacterData CharacterData, const FVector& Location, const FRotator& Rotation)
 {
 	float GravityForce = Gravity;
 
-	if (IsPlayerGrounded())
+	bWasGroundedLastStep = IsPlayerGrounded(Location);
+
+	if (bWasGroundedLastStep)
 	{
 		if (!CanJump)
 		{
@@ -409,8 +746,10 @@ FVector APlayerCharacter::GetMoveDirection(FClientCharacterData CharacterData)
 			}
 		}
 
-		FVector ForwardVector = CharacterData.VerticalInput * GetActorForwardVector() * VerticalMovementSpeed;
-		FVector RightVector = CharacterData.HorizontalInput * GetActorRightVector() * HorizontalMovementSpeed;
+		const FRotationMatrix RotationMatrix(Rotation);
+
+		FVector ForwardVector = CharacterData.VerticalInput * RotationMatrix.GetUnitAxis(EAxis::X) * VerticalMovementSpeed;
+		FVector RightVector = CharacterData.HorizontalInput * RotationMatrix.GetUnitAxis(EAxis::Y) * HorizontalMovementSpeed;
 
 		MoveDirection = ForwardVector + RightVector;
 		MoveDirection.Z = 0;
@@ -438,21 +777,69 @@ FVector APlayerCharacter::GetMoveDirection(FClientCharacterData CharacterData)
 	return MoveDirection;
 }
 
-//Set the rotation of the player (direction the player faces)
-void APlayerCharacter::SetLookRotation(FClientCharacterData CharacterData)
+/*
+* Plausibility envelope - accepts the clients result of a plain grounded move without re-simulating it (ww.Net.TrustedMoves)
+* - Only moves that follow a grounded step without a jump qualify, the client result has to match the closed form grounded step
+*   within the error margins & a single sweep along the move has to be free of geometry
+* - Moves near geometry, jumps, falls & every MaxTrustedMovesInRow move run the full simulation, which traces the ground again
+* - The server keeps its own closed form result, the client result is only compared against it
+*/
+bool APlayerCharacter::SimulateTrustedMove(const FClientCharacterData& CharacterData, FVector& Location, FRotator& Rotation)
 {
-	FRotator newRot;
-	newRot = GetActorRotation();
+	const bool bCanTrustState = bWasGroundedLastStep && CanJump && MoveDirection.Z == 0 && CharacterData.UpInput == 0;
 
-	HorizontalPlayerTurnVal += CharacterData.HorizontalLookInput;
-	newRot.Yaw = HorizontalPlayerTurnVal;
+	if (CVarTrustedMoves.GetValueOnGameThread() == 0 || !bCanTrustState || Server_TrustedMovesInRow >= MaxTrustedMovesInRow)
+	{
+		Server_TrustedMovesInRow = 0;
+		return false;
+	}
+
+	//Same as the grounded branch of GetMoveDirection & SetLookRotation, without the ground trace
+	const FRotationMatrix RotationMatrix(Rotation);
+
+	FVector TrustedMoveDirection = CharacterData.VerticalInput * RotationMatrix.GetUnitAxis(EAxis::X) * VerticalMovementSpeed
+		+ CharacterData.HorizontalInput * RotationMatrix.GetUnitAxis(EAxis::Y) * HorizontalMovementSpeed;
+	TrustedMoveDirection.Z = 0;
+
+	const float TrustedTurnVal = HorizontalPlayerTurnVal + CharacterData.HorizontalLookInput;
+	const FVector TrustedDelta = TrustedMoveDirection * CharacterData.DeltaTime;
+	const FVector TrustedLocation = Location + TrustedDelta;
+
+	FRotator TrustedRotation = Rotation;
+	TrustedRotation.Yaw = TrustedTurnVal;
 
-	SetActorRotation(newRot);
+	const bool bIsInsideEnvelope = FVector::Dist(TrustedLocation, CharacterData.Location) <= MaxLocationErrorMargin
+		&& FMath::Abs(FRotator::NormalizeAxis(TrustedTurnVal - CharacterData.Rotation.Yaw)) < MaxRotationErrorMargin;
+
+	if (!bIsInsideEnvelope || MovementComponent->IsMoveBlocked(Location, TrustedRotation, TrustedDelta))
+	{
+		Server_TrustedMovesInRow = 0;
+		return false;
+	}
+
+	Location = TrustedLocation;
+	Rotation = TrustedRotation;
+	HorizontalPlayerTurnVal = TrustedTurnVal;
+	MoveDirection = TrustedMoveDirection;
+
+	Server_TrustedMovesInRow++;
+	INC_DWORD_STAT(STAT_NetcodeTrustedMoves);
+
+	return true;
 }
 
-bool APlayerCharacter::IsPlayerGrounded()
+//Set the rotation of the player (direction the player faces)
+void APlayerCharacter::SetLookRotation(FClientCharacterData CharacterData, FRotator& Rotation)
 {
-	FVector Start = GetActorLocation();
+	HorizontalPlayerTurnVal += CharacterData.HorizontalLookInput;
+	Rotation.Yaw = HorizontalPlayerTurnVal;
+}
+
+bool APlayerCharacter::IsPlayerGrounded(const FVector& Location)
+{
+	SCOPE_NETCODE_TIMER(STAT_IsPlayerGrounded, &NetcodeTiming);
+
+	FVector Start = Location;
 	FVector End = Start;
 
 	Start.Z += 5;
@@ -469,17 +856,27 @@ bool APlayerCharacter::IsPlayerGrounded()
 
 }
 
-bool APlayerCharacter::RewindServerCharacterLocation(int16 SimulationID)
+//Combining is only exact while grounded & able to jump - the move direction then only depends on the input
+//A move that jumps or turns can never be combined into, so it is sent right away
+bool APlayerCharacter::CanCombineMoveFrom(const FClientCharacterData& CharacterData, const FVector& StartLocation)
 {
-	if (Server_CharacterDataHistory.Find(SimulationID) != nullptr)
-	{
-		FServerCharacterData TempData = *Server_CharacterDataHistory.Find(SimulationID);
+	return CanJump && CharacterData.UpInput == 0 && CharacterData.HorizontalLookInput == 0 && IsPlayerGrounded(StartLocation);
+}
+
+bool APlayerCharacter::RewindServerCharacterLocation(int32 HistoryServerTick)
+{
+	SCOPE_NETCODE_TIMER(STAT_RewindServerCharacterLocation, &NetcodeTiming);
 
+	const FWorldSnapshotHistory* SnapshotHistory = AMainGameState::GetWorldSnapshotHistory(this);
+	const FPawnSnapshot* Snapshot = SnapshotHistory ? SnapshotHistory->GetPawnSnapshot(HistoryServerTick, WorldSnapshotSlot) : nullptr;
+
+	if (Snapshot != nullptr)
+	{
 		PreviousLocation_LC = GetActorLocation();
 		PreviousRotation_LC = GetActorRotation();
 
-		SetActorLocation(TempData.Location);
-		SetActorRotation(TempData.Rotation);
+		SetActorLocation(Snapshot->Location);
+		SetActorRotation(Snapshot->Rotation);
 
 		return true;
 	}
@@ -490,40 +887,222 @@ bool APlayerCharacter::RewindServerCharacterLocation(int16 SimulationID)
 
 }
 
+//Hitboxes are built from the snapshot transform when queried instead of being stored for every step
+bool APlayerCharacter::GetHitboxHistory(int32 HistoryServerTick, FPlayerHitboxSet& OutHitboxes) const
+{
+	const FWorldSnapshotHistory* SnapshotHistory = AMainGameState::GetWorldSnapshotHistory(this);
+	const FPawnSnapshot* Snapshot = SnapshotHistory ? SnapshotHistory->GetPawnSnapshot(HistoryServerTick, WorldSnapshotSlot) : nullptr;
+
+	if (!Snapshot)
+	{
+		return false;
+	}
+
+	OutHitboxes.Build(FTransform(Snapshot->Rotation, Snapshot->Location, GetActorScale3D()), HitboxDefinitions);
+
+	return true;
+}
+
+void APlayerCharacter::GetDisplayedHitboxes(FPlayerHitboxSet& OutHitboxes) const
+{
+	OutHitboxes.Build(GetActorTransform(), HitboxDefinitions);
+}
+
+//Server move of the interpolation data set the character is shown closest to, the newest simulated move when it is not interpolated
+int16 APlayerCharacter::GetDisplayedSimulationID() const
+{
+	if (Role == ROLE_SimulatedProxy && bEnableEntityInterpolation && bCanInterpolateData)
+	{
+		return Step < 0.5f ? PreviousInterpolationData.SimulationID : TargetInterpolationData.SimulationID;
+	}
+
+	return CharacterSimulatedData.SimulationID;
+}
+
+//Server - tests a single ray against the hitboxes of the character at the tick, no actor is moved
+bool APlayerCharacter::CheckForProjectileImpact(const FHitboxRay& ProjectileRay, int32 HistoryServerTick, FHitboxRayResult& OutResult) const
+{
+	FPlayerHitboxSet Hitboxes;
+
+	if (!GetHitboxHistory(HistoryServerTick, Hitboxes))
+	{
+		return false;
+	}
+
+	const FPlayerHitboxSet* HitboxSetPtr = &Hitboxes;
+	HitboxKernel::RaycastHitboxes(&ProjectileRay, 1, &HitboxSetPtr, 1, &OutResult);
+
+	return OutResult.HitboxSetIndex != INDEX_NONE;
+}
+
 /*
 * -- Network Functions - Server to Client Communication --
 */
 
-bool APlayerCharacter::Server_SendClientCharacterData_Validate(FClientCharacterData Client_CharacterData)
+bool APlayerCharacter::Server_SendClientCharacterData_Validate(FClientCharacterData Client_CharacterData, const TArray<FClientCharacterData>& RedundantMoves)
+{
+	if (RedundantMoves.Num() > MAX_INPUT_REDUNDANCY || !IsValidClientMove(Client_CharacterData))
+	{
+		return false;
+	}
+
+	for (const FClientCharacterData& RedundantMove : RedundantMoves)
+	{
+		if (!IsValidClientMove(RedundantMove))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool APlayerCharacter::Server_RequestCorrection_Validate()
 {
 	return true;
 }
 
+//Owning client could not match an acknowledgement hash, the next owner update sends the full server result
+void APlayerCharacter::Server_RequestCorrection_Implementation()
+{
+	FNetTrafficStats::Get().RecordRpcReceived(ENetRpc::Server_RequestCorrection, 0);
+
+	bIsCorrectionRequested = true;
+}
+
 //Send local clients character input data to the server for simulation
-void APlayerCharacter::Server_SendClientCharacterData_Implementation(FClientCharacterData Client_CharacterData)
+void APlayerCharacter::Server_SendClientCharacterData_Implementation(FClientCharacterData Client_CharacterData, const TArray<FClientCharacterData>& RedundantMoves)
 {
+	FNetTrafficStats::Get().RecordRpcReceived(ENetRpc::Server_SendClientCharacterData, FNetTrafficStats::GetSerializedBits(Client_CharacterData) + FNetTrafficStats::GetSerializedBits(RedundantMoves));
+
 	if (Role == ROLE_Authority)
 	{
-		Server_CharacterData = Client_CharacterData;
+		for (const FClientCharacterData& RedundantMove : RedundantMoves)
+		{
+			ReceiveClientMove(RedundantMove);
+		}
+
+		ReceiveClientMove(Client_CharacterData);
+	}
+}
+
+/*
+* Buffers the move if it is newer than the last received one, redundant copies of moves that already arrived are dropped
+* - The input buffer is a preallocated SPSC ring, the RPC is the only producer & ConsumeServerInputBuffer the only consumer
+* - A full buffer drops the move, the client gets corrected like for a lost packet
+*/
+void APlayerCharacter::ReceiveClientMove(const FClientCharacterData& Move)
+{
+	if (!PredictedMoveID::IsNewer(Move.SimulationID, Server_LastReceivedSimulationID))
+	{
+		return;
+	}
+
+	if (!Server_InputBuffer.Enqueue(Move))
+	{
+		FNetTrafficStats::Get().RecordInputBufferOverflow();
+		return;
+	}
+
+	Server_LastReceivedSimulationID = Move.SimulationID;
+	Server_BufferedMoves++;
+	Server_BufferedInputTime += Move.DeltaTime;
+}
+
+/*
+* Simulates the buffered client moves that fit into the time passed on the server
+* - An empty buffer stalls the client (counted as an underrun), the budget is capped so the next moves do not arrive as one burst
+* - A buffer far over its target (client hitch) is caught up on immediately instead of adding latency
+*/
+void APlayerCharacter::ConsumeServerInputBuffer(float DeltaTime)
+{
+	//Combined client moves can be longer than a server frame, the budget has to be able to fit one
+	Server_InputTimeBudget = FMath::Min(Server_InputTimeBudget + DeltaTime, FMath::Max3(DeltaTime, TargetInputBufferTime, MovementComponent->MoveHeartbeatInterval));
+
+	FClientCharacterData CharacterData;
+
+	while (Server_InputBuffer.Peek(CharacterData))
+	{
+		const bool bIsOverBuffered = Server_BufferedInputTime > TargetInputBufferTime * 4;
+
+		if (CharacterData.DeltaTime > Server_InputTimeBudget && !bIsOverBuffered)
+		{
+			break;
+		}
+
+		Server_InputBuffer.Pop();
+		Server_BufferedMoves--;
+		Server_BufferedInputTime = FMath::Max(Server_BufferedInputTime - CharacterData.DeltaTime, 0.0f);
+		Server_InputTimeBudget = FMath::Max(Server_InputTimeBudget - CharacterData.DeltaTime, 0.0f);
+
+		Server_CharacterData = CharacterData;
+		SessionRecorder.RecordClientMove(Server_CharacterData, GetWorld()->GetTimeSeconds());
 		MoveCharacter(true, Server_CharacterData);
 	}
+
+	//Only count the first frame of every underrun
+	const bool bIsStarved = Server_InputBuffer.IsEmpty() && Server_InputTimeBudget >= TargetInputBufferTime;
+
+	if (bIsStarved && !bIsInputBufferStarved)
+	{
+		FNetTrafficStats::Get().RecordInputBufferUnderrun();
+	}
+
+	bIsInputBufferStarved = bIsStarved;
+
+	//Smoothed over roughly half a second so single late packets do not swing the clients time dilation
+	Server_AverageBufferedInputTime = FMath::Lerp(Server_AverageBufferedInputTime, Server_BufferedInputTime, FMath::Min(DeltaTime * 2, 1.0f));
 }
 
-bool APlayerCharacter::MultiCastClient_ReplicatePawnToClients_Validate(FServerCharacterData Server_CharacterData)
+//Difference between the buffered & target input time in milliseconds, positive when the client is ahead
+int8 APlayerCharacter::GetInputBufferError() const
 {
-	return true;
+	return (int8)FMath::Clamp(FMath::RoundToInt((Server_AverageBufferedInputTime - TargetInputBufferTime) * 1000), -127, 127);
 }
 
-//Send all clients the simulated server character results
-void APlayerCharacter::MultiCastClient_ReplicatePawnToClients_Implementation(FServerCharacterData SimulatedCharacterData)
+//Slow down when the server has too much input buffered, speed up when it is running dry
+void APlayerCharacter::ApplyInputBufferError(int8 InputBufferError)
 {
-	CharacterSimulatedData = SimulatedCharacterData;
+	const float ErrorSeconds = InputBufferError / 1000.0f;
 
-	if (Role == ROLE_SimulatedProxy)
+	ClientTimeDilation = 1 - FMath::Clamp(ErrorSeconds / FMath::Max(TargetInputBufferTime, KINDA_SMALL_NUMBER) * MaxClientTimeDilation, -MaxClientTimeDilation, MaxClientTimeDilation);
+}
+
+void APlayerCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	//The owning client predicts its own movement & only needs acknowledgements / corrections
+	DOREPLIFETIME_CONDITION(APlayerCharacter, ReplicatedCharacterData, COND_SkipOwner);
+}
+
+void APlayerCharacter::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+
+	//Count the replicated server result once per new simulation step
+	if (ReplicatedCharacterData.SimulationID != LastReplicatedSimulationID)
+	{
+		LastReplicatedSimulationID = ReplicatedCharacterData.SimulationID;
+
+		UNetDriver* NetDriver = GetNetDriver();
+		FNetTrafficStats::Get().RecordRpcSent(ENetRpc::ReplicatedCharacterData, FNetTrafficStats::GetSerializedBits(ReplicatedCharacterData), NetDriver ? FMath::Max(NetDriver->ClientConnections.Num() - 1, 0) : 0);
+	}
+}
+
+//Simulated server character results on the other clients
+void APlayerCharacter::OnRep_ReplicatedCharacterData()
+{
+	FNetTrafficStats::Get().RecordRpcReceived(ENetRpc::ReplicatedCharacterData, FNetTrafficStats::GetSerializedBits(ReplicatedCharacterData));
+
+	CharacterSimulatedData = ReplicatedCharacterData;
+
+#if !UE_SERVER
+	if (Role == ROLE_SimulatedProxy && !bIsPlayingKillcam)
 	{
 		if (bEnableEntityInterpolation)
 		{
-			AddInterpolationData(SimulatedCharacterData);
+			AddInterpolationData(ReplicatedCharacterData);
 		}
 		else
 		{
@@ -533,82 +1112,187 @@ void APlayerCharacter::MultiCastClient_ReplicatePawnToClients_Implementation(FSe
 			//GEngine->AddOnScreenDebugMessage(-1, 0.05f, FColor::Red, "Ex-Client Data | Receiving | Actor Label = " + GetActorLabel());
 		}
 	}
-	else if (Role == ROLE_AutonomousProxy)
-	{
-		CompareServerToClientSimulationResults();
-
-		//GEngine->AddOnScreenDebugMessage(-1, 0.05f, FColor::Red, "Compare Results| Receiving | | Actor Label = " + GetActorLabel());
-	}
+#endif
 }
 
 /*
-* Debug Functions
+* Server agreed with the owning clients prediction
+* - Drops the acknowledged moves & checks the stored prediction against the hash of the server result
+* - A mismatch means the prediction diverged below the servers error margin, the full server result is requested once
 */
-
-void APlayerCharacter::DisplayClientPredictionsHistory()
+void APlayerCharacter::Client_AcknowledgeMove_Implementation(int16 AcknowledgedSimulationID, uint32 StateHash, int8 InputBufferError)
 {
-	FVector dLocation = GetActorLocation();
-	dLocation.Z += 100;
+	FNetTrafficStats::Get().RecordRpcReceived(ENetRpc::Client_AcknowledgeMove, 16 + 32 + 8);
+
+	ApplyInputBufferError(InputBufferError);
+
+	FCharacterPredictedMovement::FSavedMove AcknowledgedMove;
+	const bool bFoundPrediction = MovementComponent->GetPrediction().AcknowledgeMove(AcknowledgedSimulationID, AcknowledgedMove);
+
+	if (bFoundPrediction && !MatchesCharacterStateHash(AcknowledgedMove.State.Location, AcknowledgedMove.State.Rotation, AcknowledgedMove.State.MovementState, StateHash))
+	{
+		UE_LOG(LogWesternWar, Verbose, TEXT("Move acknowledgement %d does not match the stored prediction, requesting a correction"), AcknowledgedSimulationID);
 
-	//if (FVector::Dist(Debug_LastPredictionLocation, dLocation) >= 1)
-	//{
-		DrawDebugPoint(GetWorld(), dLocation, 5, FColor().Green, false, 3);
+		//Only one request in flight, the correction that answers it clears the flag & a lost request is resent after a timeout
+		const float CurrentTime = GetWorld()->GetTimeSeconds();
 
-		if (Debug_LastPredictionLocation != FVector::ZeroVector)
+		if (!bHasRequestedCorrection || CurrentTime - CorrectionRequestTime > CORRECTION_REQUEST_TIMEOUT)
 		{
-			DrawDebugLine(GetWorld(), Debug_LastPredictionLocation, dLocation, FColor().Green, false, 3, 0, 0.1f);
+			bHasRequestedCorrection = true;
+			CorrectionRequestTime = CurrentTime;
+			Server_RequestCorrection();
+			FNetTrafficStats::Get().RecordRpcSent(ENetRpc::Server_RequestCorrection, 0);
 		}
-	//}
+	}
+}
+
+//Server disagreed with the owning clients prediction - rewind to the server result & replay the newer moves
+void APlayerCharacter::Client_CorrectMove_Implementation(FServerCharacterData CorrectedCharacterData, int8 InputBufferError)
+{
+	FNetTrafficStats::Get().RecordRpcReceived(ENetRpc::Client_CorrectMove, FNetTrafficStats::GetSerializedBits(CorrectedCharacterData) + 8);
+
+	ApplyInputBufferError(InputBufferError);
+
+	bHasRequestedCorrection = false;
+	CharacterSimulatedData = CorrectedCharacterData;
 
-	Debug_LastPredictionLocation = dLocation;
+	if (bEnableServerSimulationHistory)
+	{
+		RecordNetDebugSample(ENetDebugSample::ServerSimulation, CharacterSimulatedData.Location);
+	}
+
+	SessionRecorder.RecordServerSnapshot(CharacterSimulatedData, GetWorld()->GetTimeSeconds());
+
+	CompareServerToClientSimulationResults();
 }
 
-void APlayerCharacter::DisplayServerSimulationsHistory()
+/*
+* Offline re-simulation of a net recording
+* - Starts from the result of the first recorded move & runs every following move through SimulateMove
+* - Compares against the recorded move results & the server snapshots matched to the moves by simulation ID
+*/
+void APlayerCharacter::ResimulateRecording(const FNetSessionRecording& Recording)
 {
-	FVector dLocation = CharacterSimulatedData.Location;
-	dLocation.Z += 100;
+	const TArray<FRecordedClientMove>& Moves = Recording.Moves;
 
-	//if (FVector::Dist(Debug_LastSimulatedLocation, dLocation) >= 1)
-	//{
-		DrawDebugPoint(GetWorld(), dLocation, 5, FColor().Yellow, false, 3);
+	if (Moves.Num() < 2)
+	{
+		UE_LOG(LogWesternWar, Warning, TEXT("Net Replay | Recording has no moves to re-simulate"));
+		return;
+	}
+
+	//Match every server snapshot to the latest move recorded before it with the same ID (IDs wrap around)
+	TArray<int32> SnapshotForMove;
+	SnapshotForMove.Init(INDEX_NONE, Moves.Num());
 
-		if (Debug_LastSimulatedLocation != FVector::ZeroVector)
+	int32 MoveCursor = 0;
+	for (int32 SnapshotIndex = 0; SnapshotIndex < Recording.Snapshots.Num(); SnapshotIndex++)
+	{
+		const FRecordedServerSnapshot& Snapshot = Recording.Snapshots[SnapshotIndex];
+
+		while (MoveCursor + 1 < Moves.Num() && Moves[MoveCursor + 1].Time <= Snapshot.Time)
 		{
-			DrawDebugLine(GetWorld(), Debug_LastSimulatedLocation, dLocation, FColor().Yellow, false, 3, 0, 0.1f);
+			MoveCursor++;
 		}
-	//}
 
-	Debug_LastSimulatedLocation = dLocation;
-}
+		//Simulation IDs wrap after PREDICTED_MOVE_ID_RANGE moves, so only that many moves back can carry the snapshots ID
+		for (int32 MoveIndex = MoveCursor; MoveIndex >= 0 && MoveIndex > MoveCursor - PREDICTED_MOVE_ID_RANGE; MoveIndex--)
+		{
+			if (Moves[MoveIndex].Move.SimulationID == Snapshot.Snapshot.SimulationID)
+			{
+				SnapshotForMove[MoveIndex] = SnapshotIndex;
+				break;
+			}
+		}
+	}
 
-void APlayerCharacter::DisplayFixedPredictionsHistory(FVector Location)
-{
-	FVector dLocation = Location;
-	dLocation.Z += 100;
+	//Keep the live state so the character can be put back after the re-simulation
+	const FCharacterMovementState LiveMovementState = GetMovementState();
+
+	//Re-simulated on its own state, the character itself is not moved
+	FVector Location = Moves[0].Move.Location;
+	FRotator Rotation = Moves[0].Move.Rotation;
+
+	FCharacterMovementState StartMovementState;
+	StartMovementState.HorizontalTurnVal = Moves[0].Move.Rotation.Yaw;
+	SetMovementState(StartMovementState);
+
+	int32 RecordingMismatches = 0;
+	int32 SnapshotMismatches = 0;
+	int32 RecordedCorrections = 0;
+	float MaxRecordingError = 0;
+	double SimulationTime = 0;
+
+	for (int32 MoveIndex = 1; MoveIndex < Moves.Num(); MoveIndex++)
+	{
+		const FClientCharacterData& Move = Moves[MoveIndex].Move;
+
+		const double StartTime = FPlatformTime::Seconds();
+		SimulateMove(Move, Location, Rotation);
+		SimulationTime += FPlatformTime::Seconds() - StartTime;
 
-	//if (FVector::Dist(Debug_LastFixedLocation, dLocation) >= 1)
-	//{
-		DrawDebugPoint(GetWorld(), dLocation, 5, FColor().Blue, false, 3);
+		const float RecordingError = FVector::Dist(Location, Move.Location);
+		MaxRecordingError = FMath::Max(MaxRecordingError, RecordingError);
 
-		if (Debug_LastFixedLocation != FVector::ZeroVector)
+		if (RecordingError > MaxLocationErrorMargin)
 		{
-			DrawDebugLine(GetWorld(), Debug_LastFixedLocation, dLocation, FColor().Blue, false, 3, 0, 0.1f);
+			RecordingMismatches++;
 		}
-	//}
 
-	Debug_LastFixedLocation = dLocation;
-}
+		if (SnapshotForMove[MoveIndex] != INDEX_NONE)
+		{
+			const FServerCharacterData& Snapshot = Recording.Snapshots[SnapshotForMove[MoveIndex]].Snapshot;
 
-void APlayerCharacter::DisplayWrongPredictionMoment(FVector Location)
-{
-	FVector Temp = Location;
-	Temp.Z += 100;
+			if (FVector::Dist(Location, Snapshot.Location) > MaxLocationErrorMargin)
+			{
+				SnapshotMismatches++;
+			}
+
+			//Corrections the live session made - the recorded result did not match the server
+			if (FVector::Dist(Move.Location, Snapshot.Location) > MaxLocationErrorMargin)
+			{
+				RecordedCorrections++;
+			}
+		}
+	}
+
+	SetMovementState(LiveMovementState);
+
+	UE_LOG(LogWesternWar, Log, TEXT("Net Replay | Moves: %d | Snapshots: %d | Simulation: %.3f ms (%.2f us per move)"),
+		Moves.Num() - 1, Recording.Snapshots.Num(), SimulationTime * 1000.0, SimulationTime * 1000000.0 / (Moves.Num() - 1));
+	UE_LOG(LogWesternWar, Log, TEXT("Net Replay | Differs From Recording: %d (max %.2f) | Differs From Server: %d | Corrections In Recording: %d"),
+		RecordingMismatches, MaxRecordingError, SnapshotMismatches, RecordedCorrections);
+}
 
-	DrawDebugPoint(GetWorld(), Temp, 30, FColor().Black, false, 3);
+/*
+* Debug Functions
+*/
 
-	Temp = GetActorLocation();
-	Temp.Z += 100;
+//Samples are only recorded while debugging is enabled, all of this is compiled out of shipping builds
+void APlayerCharacter::RecordNetDebugSample(ENetDebugSample::Type SampleType, FVector Location)
+{
+#if WW_NETCODE_DEBUG
+	if (bEnableDebug)
+	{
+		NetDebugRecorder.Record(SampleType, Location, GetWorld()->GetTimeSeconds());
+	}
+#endif
+}
 
-	DrawDebugPoint(GetWorld(), Temp, 30, FColor().Red, false, 3);
+void APlayerCharacter::BreakNetDebugLine(ENetDebugSample::Type SampleType)
+{
+#if WW_NETCODE_DEBUG
+	NetDebugRecorder.BreakLine(SampleType);
+#endif
 }
 
+//Draw all recorded samples inside the visible time window in one batch
+void APlayerCharacter::DrawNetDebugHistory()
+{
+#if WW_NETCODE_DEBUG
+	if (bEnableDebug)
+	{
+		NetDebugRecorder.Draw(GetWorld(), DebugHistoryTimeWindow, 100);
+	}
+#endif
+}
\ No newline at end of file
@@ -4,82 +4,17 @@
 
 #include "GameFramework/Pawn.h"
 #include "CharacterMovementComp.h"
+#include "CharacterNetData.h"
+#include "PlayerHitboxes.h"
+#include "NetDebugRecorder.h"
+#include "Networking/NetcodeTimingStats.h"
+#include "Networking/NetSessionRecorder.h"
+#include "Networking/SpscRingBuffer.h"
 #include "PlayerCharacter.generated.h"
 
-USTRUCT()
-struct FClientCharacterData
-{
-	GENERATED_USTRUCT_BODY()
-
-	UPROPERTY()
-		float VerticalInput;
-	UPROPERTY()
-		float HorizontalInput;
-	UPROPERTY()
-		float UpInput;
-	UPROPERTY()
-		float VerticalLookInput;
-	UPROPERTY()
-		float HorizontalLookInput;
-
-	UPROPERTY()
-		FVector Location;
-	UPROPERTY()
-		FRotator Rotation;
-
-	UPROPERTY()
-		float DeltaTime;
-	UPROPERTY()
-		int16 SimulationID;
-
-};
-
-USTRUCT()
-struct FServerCharacterData
-{
-	//Contains server data for the simulated character from local client input
-
-	GENERATED_USTRUCT_BODY()
-
-	UPROPERTY()
-		FVector Location;
-	UPROPERTY()
-		FRotator Rotation;
-	UPROPERTY()
-		float HorizontalCharacterTurnVal = 0;
-	UPROPERTY()
-		float ServerTime;
-
-	UPROPERTY()
-		int16 SimulationID;
-};
-
-USTRUCT()
-struct FInterpolationData
-{
-	//Contains server data for the simulated character from local client input thats required for interpolation on clients
-
-	GENERATED_USTRUCT_BODY()
-
-	UPROPERTY()
-		FVector Location;
-	UPROPERTY()
-		FRotator Rotation;
-	UPROPERTY()
-		float ServerTime;
-	UPROPERTY()
-		bool bIsEmpty = true;
-
-	static FInterpolationData Lerp(FInterpolationData FromData, FInterpolationData ToData, float Step)
-	{
-		FInterpolationData Result;
-
-		Result.Location = FMath::Lerp(FromData.Location, ToData.Location, Step);
-		Result.Rotation = FMath::Lerp(FromData.Rotation, ToData.Rotation, Step);
-
-		return Result;
-	}
-};
+#define SERVER_INPUT_BUFFER_CAPACITY 128	//Client moves the server buffers at most (~2 seconds of uncombined moves at 60 FPS)
+#define INTERPOLATION_BUFFER_CAPACITY 32	//Server states a simulated proxy buffers at most
+#define CORRECTION_REQUEST_TIMEOUT 0.5f	//Seconds before an unanswered correction request is resent
 
 UCLASS()
 class WESTERNWAR_API APlayerCharacter : public APawn
@@ -92,15 +27,14 @@ private:
 	void VerticalLookInput(float val);
 	void HorizontalLookInput(float val);
 
-	//Networking Debugs
-	void DisplayClientPredictionsHistory();
-	void DisplayServerSimulationsHistory();
-	void DisplayFixedPredictionsHistory(FVector Location);
-	void DisplayWrongPredictionMoment(FVector Location);
+	//Networking Debugs - compiled out of shipping builds
+	void RecordNetDebugSample(ENetDebugSample::Type SampleType, FVector Location);
+	void BreakNetDebugLine(ENetDebugSample::Type SampleType);
+	void DrawNetDebugHistory();
 
-	FVector Debug_LastPredictionLocation;
-	FVector Debug_LastSimulatedLocation;
-	FVector Debug_LastFixedLocation;
+#if WW_NETCODE_DEBUG
+	FNetDebugRecorder NetDebugRecorder;
+#endif
 
 	//Character Data 
 	FClientCharacterData Client_CharacterData;
@@ -114,60 +48,135 @@ private:
 
 	int InterpolationDataReceived = 0;
 	int ServerSimulationSteps = 0;
-
-	TQueue<FClientCharacterData, EQueueMode::Mpsc> Client_CharacterInputDataQueue;
-	TQueue<FInterpolationData, EQueueMode::Mpsc> InterpolationDataQueue;
+	int16 Server_LastReceivedSimulationID = 0;
+	int16 LastReplicatedSimulationID = 0;
+
+	bool bIsCorrectionRequested = false;	//Server - the owning client asked for the full result
+	bool bHasRequestedCorrection = false;	//Owning client - waiting for the correction it asked for
+	float CorrectionRequestTime = 0;
+
+	/*
+	* Server input buffer - moves are simulated at the servers own rate instead of on arrival
+	* - The buffered time is reported back to the owning client, which dilates its simulation time to keep the buffer at TargetInputBufferTime
+	*/
+	TSpscRingBuffer<FClientCharacterData, SERVER_INPUT_BUFFER_CAPACITY> Server_InputBuffer;
+	int32 Server_BufferedMoves = 0;
+	float Server_BufferedInputTime = 0;
+	float Server_AverageBufferedInputTime = 0;
+	float Server_InputTimeBudget = 0;
+	bool bIsInputBufferStarved = false;
+
+	float ClientTimeDilation = 1;
+
+	void ConsumeServerInputBuffer(float DeltaTime);
+	int8 GetInputBufferError() const;
+	void ApplyInputBufferError(int8 InputBufferError);
+	TSpscRingBuffer<FInterpolationData, INTERPOLATION_BUFFER_CAPACITY> InterpolationDataQueue;
 
 	FInterpolationData TargetInterpolationData;
 	FInterpolationData PreviousInterpolationData;
 	bool bCanStartNewInterpolationSet = true;
 	float Step = 0;
 
+	//Killcam playback poses the character instead of the replicated updates
+	bool bIsPlayingKillcam = false;
+	void ResetInterpolation();
+
 	void MoveCharacter(bool bIsServerSide, FClientCharacterData CharacterData);
+	void SimulateMove(FClientCharacterData CharacterData, FVector& Location, FRotator& Rotation);
 	void InterpolateMovementData();
 	void AddInterpolationData(FServerCharacterData ServerData);
 	void RotateCamera();
 
-	bool IsPlayerGrounded();
+	bool IsPlayerGrounded(const FVector& Location);
+	bool CanCombineMoveFrom(const FClientCharacterData& CharacterData, const FVector& StartLocation);
 	bool CanJump = true;
 	float JumpTimer = 0;
+	bool bWasGroundedLastStep = false;	//Ground state at the start of the last simulated step
+
+	//Server plausibility envelope - plain grounded moves are checked against a closed form step instead of being re-simulated
+	bool SimulateTrustedMove(const FClientCharacterData& CharacterData, FVector& Location, FRotator& Rotation);
+	int32 Server_TrustedMovesInRow = 0;
 
 	void CompareServerToClientSimulationResults();
 	void RewindAndReplay();
+	friend struct FCharacterPredictionStep;
 
-	FVector GetMoveDirection(FClientCharacterData CharacterData);
-	void SetLookRotation(FClientCharacterData CharacterData);
+	bool IsPredictionWithinErrorMargin(const FClientCharacterData& Prediction, const FServerCharacterData& ServerData) const;
+	void SendPendingMove();
+	void ReceiveClientMove(const FClientCharacterData& Move);
+
+	//Saves where the nearby simulated proxies are shown, so replaying the move collides with them there
+	//Gathered once per frame, every move sent in the same frame saw the proxies at the same place
+	void GatherReplayProxies(FReplayProxyFrame& OutProxyFrame);
+	FReplayProxyFrame CachedReplayProxyFrame;
+	uint64 CachedReplayProxyFrameNumber = 0;
+
+	//Last sent moves, resent with every move on lossy links (input redundancy)
+	TArray<FClientCharacterData> RecentSentMoves;
+
+	class AMainPlayerState* GetMainPlayerState() const;
+	class AMainPlayerState* GetLocalMainPlayerState() const;
+
+	FVector GetMoveDirection(FClientCharacterData CharacterData, const FVector& Location, const FRotator& Rotation);
+	void SetLookRotation(FClientCharacterData CharacterData, FRotator& Rotation);
 
 	FVector MoveDirection = FVector::ZeroVector;
 
+	//Everything the movement step reads besides the transform, saved with every move & restored before a replay
+	FCharacterMovementState GetMovementState() const;
+	void SetMovementState(const FCharacterMovementState& MovementState);
+
 	float HorizontalPlayerTurnVal = 0;	//Stores the value by which the camera is rotated horizontally (around y axis)
 	float VerticalCameraTurnVal = 0;	//Stores the value by which the camera is rotated vertically (around x axis)
 
-	//Lag Compensation
-	TMap<int16, FServerCharacterData> Server_CharacterDataHistory;
-	bool RewindServerCharacterLocation(int16 SimulationID);
-	void CheckForProjectileImpact(FVector ProjectileStart, FVector ProjectileDirection);
+	//Lag Compensation - the transform history is kept for every pawn in the world snapshot history of AMainGameState
+	int32 WorldSnapshotSlot = INDEX_NONE;
+	bool RewindServerCharacterLocation(int32 HistoryServerTick);
 
 	FRotator PreviousRotation_LC;
 	FVector PreviousLocation_LC;
 
+	//CPU time this character spends in the netcode (per frame & per player aggregates)
+	FNetcodePlayerTiming NetcodeTiming;
+
+	//Binary recording of every move & server snapshot (ww.NetRecord)
+	FNetSessionRecorder SessionRecorder;
+
 	//Client Prediction Vars
 	float MaxLocationErrorMargin = 0.1f;
 	float MaxRotationErrorMargin = 5;
 
+	//Server simulation result for the other clients, the owning client gets acknowledgements & corrections instead
+	UPROPERTY(ReplicatedUsing = OnRep_ReplicatedCharacterData)
+		FServerCharacterData ReplicatedCharacterData;
+
+	UFUNCTION()
+		void OnRep_ReplicatedCharacterData();
+
 	//Networking functions
 	UFUNCTION(Server, Unreliable, WithValidation)
-		void Server_SendClientCharacterData(FClientCharacterData Client_CharacterData);
-	UFUNCTION(NetMulticast, Unreliable, WithValidation)
-		void MultiCastClient_ReplicatePawnToClients(FServerCharacterData Server_CharacterData);
+		void Server_SendClientCharacterData(FClientCharacterData Client_CharacterData, const TArray<FClientCharacterData>& RedundantMoves);
+	UFUNCTION(Client, Unreliable)
+		void Client_AcknowledgeMove(int16 AcknowledgedSimulationID, uint32 StateHash, int8 InputBufferError);
+	UFUNCTION(Client, Unreliable)
+		void Client_CorrectMove(FServerCharacterData CorrectedCharacterData, int8 InputBufferError);
+	UFUNCTION(Server, Unreliable, WithValidation)
+		void Server_RequestCorrection();
 
 
 public:
 	// Sets default values for this pawn's properties
 	APlayerCharacter();
 
+	virtual void PostInitializeComponents() override;
+
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
 	
 	// Called every frame
 	virtual void Tick( float DeltaSeconds ) override;
@@ -175,6 +184,9 @@ public:
 	// Called to bind functionality to input
 	virtual void SetupPlayerInputComponent(class UInputComponent* InputComponent) override;
 
+	//Re-simulate every move of a recording from its first recorded state & log the differences (ww.NetReplay)
+	void ResimulateRecording(const FNetSessionRecording& Recording);
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "RootMesh")
 		UStaticMeshComponent *RootMesh;
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "MovementComponent")
@@ -208,9 +220,41 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Control Properties|Interpolation")
 		bool bEnableEntityInterpolation = true;
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Control Properties|Input Buffer")
+		float TargetInputBufferTime = 0.05f;	//Seconds of client input the server tries to keep buffered
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Control Properties|Input Buffer")
+		float MaxClientTimeDilation = 0.05f;	//Max fraction the client simulation is sped up or slowed down by
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Control Properties|Trusted Moves")
+		int32 MaxTrustedMovesInRow = 4;	//A full simulation is forced after this many trusted moves, which checks the ground again
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Control Properties|Replay")
+		float ReplayProxyRadius = 500;	//Simulated proxies closer than this are rewound with the moves they could collide with
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Lag Compensation|Hitboxes")
+		TArray<FHitboxCapsuleDefinition> HitboxDefinitions;
+
+	//Builds the hitboxes of the character at the given server tick, false if the tick is not in the world snapshot history
+	bool GetHitboxHistory(int32 HistoryServerTick, FPlayerHitboxSet& OutHitboxes) const;
+
+	int32 GetWorldSnapshotSlot() const { return WorldSnapshotSlot; }
+
+	//Hit Prediction - the shooting client traces the hitboxes where it shows the character, the server verifies the hit at the matching tick
+	void GetDisplayedHitboxes(FPlayerHitboxSet& OutHitboxes) const;
+	int16 GetDisplayedSimulationID() const;
+	bool CheckForProjectileImpact(const FHitboxRay& ProjectileRay, int32 HistoryServerTick, FHitboxRayResult& OutResult) const;
+
+	//Killcam - the controller poses the character from the recorded server states, simulated proxies only
+	void BeginKillcamPlayback();
+	void SetKillcamPose(const FVector& Location, const FRotator& Rotation);
+	void EndKillcamPlayback();
+	int16 GetLastSimulatedMoveID() const { return CharacterSimulatedData.SimulationID; }
+
 	//Debug
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Debug Options")
 		bool bEnableDebug = false;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Debug Options|Networking")
+		float DebugHistoryTimeWindow = 3;	//How many seconds of recorded samples are drawn
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Debug Options|Networking|Prediction & Recoincilation")
 		bool bEnablePredictionHistory = true;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Debug Options|Networking|Prediction & Recoincilation")
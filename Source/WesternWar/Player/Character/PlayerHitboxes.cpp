@@ -0,0 +1,342 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#include "WesternWar.h"
+#include "PlayerHitboxes.h"
+
+FPlayerHitboxSet::FPlayerHitboxSet()
+{
+	for (int32 i = 0; i < MAX_PLAYER_HITBOXES; i++)
+	{
+		StartX[i] = StartY[i] = StartZ[i] = 0;
+		EndX[i] = EndY[i] = EndZ[i] = 0;
+		RadiusSquared[i] = -1;
+		Region[i] = EHitboxRegion::HR_None;
+	}
+}
+
+//Transform the capsule definitions of the character into world space
+void FPlayerHitboxSet::Build(const FTransform& CharacterTransform, const TArray<FHitboxCapsuleDefinition>& Definitions)
+{
+	const int32 NumHitboxes = FMath::Min(Definitions.Num(), MAX_PLAYER_HITBOXES);
+
+	for (int32 i = 0; i < MAX_PLAYER_HITBOXES; i++)
+	{
+		if (i < NumHitboxes)
+		{
+			const FVector Start = CharacterTransform.TransformPosition(Definitions[i].LocalStart);
+			const FVector End = CharacterTransform.TransformPosition(Definitions[i].LocalEnd);
+
+			StartX[i] = Start.X;
+			StartY[i] = Start.Y;
+			StartZ[i] = Start.Z;
+			EndX[i] = End.X;
+			EndY[i] = End.Y;
+			EndZ[i] = End.Z;
+			RadiusSquared[i] = FMath::Square(Definitions[i].Radius);
+			Region[i] = Definitions[i].Region;
+		}
+		else
+		{
+			RadiusSquared[i] = -1;
+			Region[i] = EHitboxRegion::HR_None;
+		}
+	}
+}
+
+/*
+* Ray parameter where the ray enters the capsule - the closest approach moved back by the penetration depth along the ray
+* - Exact for the capsule caps & rays crossing the capsule axis at a right angle, slightly late for oblique rays
+*/
+static FORCEINLINE float GetHitboxEntryTime(float ClosestTime, float DistanceSquared, float RadiusSquared, float InvRayLength)
+{
+	return FMath::Max(ClosestTime - FMath::Sqrt(FMath::Max(RadiusSquared - DistanceSquared, 0.0f)) * InvRayLength, 0.0f);
+}
+
+//Closest hit so far, the first hit is always taken so hits at the very end of the ray count
+static FORCEINLINE bool IsCloserHit(const FHitboxRayResult& Result, float EntryTime)
+{
+	return Result.HitboxSetIndex == INDEX_NONE || EntryTime < Result.Time;
+}
+
+/*
+* Closest points between the ray segment (P + D*t) and the capsule segment (A + E*s), Real-Time Collision Detection 5.1.9
+* - The SIMD version runs the same steps without branches, 4 capsules at a time
+* - Only the lanes that hit convert their closest approach to the entry time
+*/
+void HitboxKernel::RaycastHitboxes(const FHitboxRay* Rays, int32 NumRays, const FPlayerHitboxSet* const* HitboxSets, int32 NumHitboxSets, FHitboxRayResult* OutResults)
+{
+	const VectorRegister Zero = VectorZero();
+	const VectorRegister One = VectorOne();
+	const VectorRegister Epsilon = VectorSetFloat1(KINDA_SMALL_NUMBER);
+
+	MS_ALIGN(16) float HitTimes[4] GCC_ALIGN(16);
+	MS_ALIGN(16) float HitDistancesSquared[4] GCC_ALIGN(16);
+
+	for (int32 RayIndex = 0; RayIndex < NumRays; RayIndex++)
+	{
+		const FVector RayDirection = Rays[RayIndex].End - Rays[RayIndex].Start;
+
+		const VectorRegister Px = VectorSetFloat1(Rays[RayIndex].Start.X);
+		const VectorRegister Py = VectorSetFloat1(Rays[RayIndex].Start.Y);
+		const VectorRegister Pz = VectorSetFloat1(Rays[RayIndex].Start.Z);
+		const VectorRegister Dx = VectorSetFloat1(RayDirection.X);
+		const VectorRegister Dy = VectorSetFloat1(RayDirection.Y);
+		const VectorRegister Dz = VectorSetFloat1(RayDirection.Z);
+		const float RayLengthSquared = FMath::Max(RayDirection.SizeSquared(), KINDA_SMALL_NUMBER);
+		const float InvRayLength = FMath::InvSqrt(RayLengthSquared);
+		const VectorRegister A = VectorSetFloat1(RayLengthSquared);
+		const VectorRegister InvA = VectorReciprocalAccurate(A);
+
+		FHitboxRayResult Result;
+
+		for (int32 SetIndex = 0; SetIndex < NumHitboxSets; SetIndex++)
+		{
+			if (SetIndex == Rays[RayIndex].IgnoredHitboxSetIndex)
+			{
+				continue;
+			}
+
+			const FPlayerHitboxSet& Set = *HitboxSets[SetIndex];
+
+			for (int32 Lane = 0; Lane < MAX_PLAYER_HITBOXES; Lane += 4)
+			{
+				const VectorRegister Ax = VectorLoad(&Set.StartX[Lane]);
+				const VectorRegister Ay = VectorLoad(&Set.StartY[Lane]);
+				const VectorRegister Az = VectorLoad(&Set.StartZ[Lane]);
+				const VectorRegister Ex = VectorSubtract(VectorLoad(&Set.EndX[Lane]), Ax);
+				const VectorRegister Ey = VectorSubtract(VectorLoad(&Set.EndY[Lane]), Ay);
+				const VectorRegister Ez = VectorSubtract(VectorLoad(&Set.EndZ[Lane]), Az);
+
+				const VectorRegister Rx = VectorSubtract(Px, Ax);
+				const VectorRegister Ry = VectorSubtract(Py, Ay);
+				const VectorRegister Rz = VectorSubtract(Pz, Az);
+
+				const VectorRegister E = VectorMax(VectorMultiplyAdd(Ex, Ex, VectorMultiplyAdd(Ey, Ey, VectorMultiply(Ez, Ez))), Epsilon);
+				const VectorRegister F = VectorMultiplyAdd(Ex, Rx, VectorMultiplyAdd(Ey, Ry, VectorMultiply(Ez, Rz)));
+				const VectorRegister C = VectorMultiplyAdd(Dx, Rx, VectorMultiplyAdd(Dy, Ry, VectorMultiply(Dz, Rz)));
+				const VectorRegister B = VectorMultiplyAdd(Dx, Ex, VectorMultiplyAdd(Dy, Ey, VectorMultiply(Dz, Ez)));
+
+				//Closest point on the ray, segments that are parallel start at the ray origin
+				const VectorRegister Denom = VectorSubtract(VectorMultiply(A, E), VectorMultiply(B, B));
+				const VectorRegister bIsNotParallel = VectorCompareGT(Denom, VectorMultiply(Epsilon, VectorMultiply(A, E)));
+				VectorRegister T = VectorMultiply(VectorSubtract(VectorMultiply(B, F), VectorMultiply(C, E)), VectorReciprocalAccurate(VectorMax(Denom, Epsilon)));
+				T = VectorSelect(bIsNotParallel, VectorMin(VectorMax(T, Zero), One), Zero);
+
+				//Closest point on the capsule segment, if it had to be clamped recompute the point on the ray
+				const VectorRegister S = VectorMultiply(VectorMultiplyAdd(B, T, F), VectorReciprocalAccurate(E));
+				const VectorRegister ClampedS = VectorMin(VectorMax(S, Zero), One);
+				const VectorRegister RecomputedT = VectorMin(VectorMax(VectorMultiply(VectorSubtract(VectorMultiply(B, ClampedS), C), InvA), Zero), One);
+				T = VectorSelect(VectorCompareNE(S, ClampedS), RecomputedT, T);
+
+				const VectorRegister DeltaX = VectorSubtract(VectorMultiplyAdd(Dx, T, Rx), VectorMultiply(Ex, ClampedS));
+				const VectorRegister DeltaY = VectorSubtract(VectorMultiplyAdd(Dy, T, Ry), VectorMultiply(Ey, ClampedS));
+				const VectorRegister DeltaZ = VectorSubtract(VectorMultiplyAdd(Dz, T, Rz), VectorMultiply(Ez, ClampedS));
+				const VectorRegister DistanceSquared = VectorMultiplyAdd(DeltaX, DeltaX, VectorMultiplyAdd(DeltaY, DeltaY, VectorMultiply(DeltaZ, DeltaZ)));
+
+				const int32 HitMask = VectorMaskBits(VectorCompareGE(VectorLoad(&Set.RadiusSquared[Lane]), DistanceSquared));
+
+				if (HitMask == 0)
+				{
+					continue;
+				}
+
+				VectorStoreAligned(T, HitTimes);
+				VectorStoreAligned(DistanceSquared, HitDistancesSquared);
+
+				for (int32 i = 0; i < 4; i++)
+				{
+					if (!(HitMask & (1 << i)))
+					{
+						continue;
+					}
+
+					const float EntryTime = GetHitboxEntryTime(HitTimes[i], HitDistancesSquared[i], Set.RadiusSquared[Lane + i], InvRayLength);
+
+					if (IsCloserHit(Result, EntryTime))
+					{
+						Result.Time = EntryTime;
+						Result.Region = (EHitboxRegion::Type)Set.Region[Lane + i];
+						Result.HitboxSetIndex = SetIndex;
+					}
+				}
+			}
+		}
+
+		OutResults[RayIndex] = Result;
+	}
+}
+
+void HitboxKernel::RaycastHitboxesScalar(const FHitboxRay* Rays, int32 NumRays, const FPlayerHitboxSet* const* HitboxSets, int32 NumHitboxSets, FHitboxRayResult* OutResults)
+{
+	for (int32 RayIndex = 0; RayIndex < NumRays; RayIndex++)
+	{
+		const FVector P = Rays[RayIndex].Start;
+		const FVector D = Rays[RayIndex].End - Rays[RayIndex].Start;
+		const float A = FMath::Max(D.SizeSquared(), KINDA_SMALL_NUMBER);
+		const float InvRayLength = FMath::InvSqrt(A);
+
+		FHitboxRayResult Result;
+
+		for (int32 SetIndex = 0; SetIndex < NumHitboxSets; SetIndex++)
+		{
+			if (SetIndex == Rays[RayIndex].IgnoredHitboxSetIndex)
+			{
+				continue;
+			}
+
+			const FPlayerHitboxSet& Set = *HitboxSets[SetIndex];
+
+			for (int32 i = 0; i < MAX_PLAYER_HITBOXES; i++)
+			{
+				if (Set.RadiusSquared[i] < 0)
+				{
+					continue;
+				}
+
+				const FVector CapsuleStart(Set.StartX[i], Set.StartY[i], Set.StartZ[i]);
+				const FVector E = FVector(Set.EndX[i], Set.EndY[i], Set.EndZ[i]) - CapsuleStart;
+				const FVector R = P - CapsuleStart;
+
+				const float e = FMath::Max(FVector::DotProduct(E, E), KINDA_SMALL_NUMBER);
+				const float f = FVector::DotProduct(E, R);
+				const float c = FVector::DotProduct(D, R);
+				const float b = FVector::DotProduct(D, E);
+				const float Denom = A * e - b * b;
+
+				float t = 0;
+
+				if (Denom > KINDA_SMALL_NUMBER * A * e)
+				{
+					t = FMath::Clamp((b * f - c * e) / Denom, 0.0f, 1.0f);
+				}
+
+				float s = (b * t + f) / e;
+
+				if (s < 0 || s > 1)
+				{
+					s = FMath::Clamp(s, 0.0f, 1.0f);
+					t = FMath::Clamp((b * s - c) / A, 0.0f, 1.0f);
+				}
+
+				const float DistanceSquared = ((R + D * t) - E * s).SizeSquared();
+
+				if (DistanceSquared > Set.RadiusSquared[i])
+				{
+					continue;
+				}
+
+				const float EntryTime = GetHitboxEntryTime(t, DistanceSquared, Set.RadiusSquared[i], InvRayLength);
+
+				if (IsCloserHit(Result, EntryTime))
+				{
+					Result.Time = EntryTime;
+					Result.Region = (EHitboxRegion::Type)Set.Region[i];
+					Result.HitboxSetIndex = SetIndex;
+				}
+			}
+		}
+
+		OutResults[RayIndex] = Result;
+	}
+}
+
+void HitboxKernel::GetDefaultHitboxDefinitions(TArray<FHitboxCapsuleDefinition>& OutDefinitions)
+{
+	OutDefinitions.Empty(6);
+
+	OutDefinitions.Add(FHitboxCapsuleDefinition(FVector(0, 0, 160), FVector(0, 0, 175), 12, EHitboxRegion::HR_Head));
+	OutDefinitions.Add(FHitboxCapsuleDefinition(FVector(0, 0, 95), FVector(0, 0, 145), 22, EHitboxRegion::HR_Body));
+	OutDefinitions.Add(FHitboxCapsuleDefinition(FVector(0, -28, 145), FVector(0, -32, 95), 7, EHitboxRegion::HR_Arm));
+	OutDefinitions.Add(FHitboxCapsuleDefinition(FVector(0, 28, 145), FVector(0, 32, 95), 7, EHitboxRegion::HR_Arm));
+	OutDefinitions.Add(FHitboxCapsuleDefinition(FVector(0, -11, 90), FVector(0, -11, 8), 9, EHitboxRegion::HR_Leg));
+	OutDefinitions.Add(FHitboxCapsuleDefinition(FVector(0, 11, 90), FVector(0, 11, 8), 9, EHitboxRegion::HR_Leg));
+}
+
+/*
+* Benchmark - ww.HitboxBenchmark [NumRays] [NumCharacters] [Iterations]
+* Runs the SIMD & scalar kernels on the same random data, logs the time per ray & how many results differ
+*/
+static void RunHitboxKernelBenchmark(const TArray<FString>& Args)
+{
+	const int32 NumRays = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 256;
+	const int32 NumCharacters = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 64;
+	const int32 Iterations = Args.Num() > 2 ? FMath::Max(FCString::Atoi(*Args[2]), 1) : 100;
+
+	FRandomStream Random(1337);
+
+	TArray<FHitboxCapsuleDefinition> Definitions;
+	HitboxKernel::GetDefaultHitboxDefinitions(Definitions);
+
+	TArray<FPlayerHitboxSet> HitboxSets;
+	TArray<const FPlayerHitboxSet*> HitboxSetPtrs;
+	HitboxSets.SetNum(NumCharacters);
+
+	for (int32 i = 0; i < NumCharacters; i++)
+	{
+		const FVector Location(Random.FRandRange(-2000, 2000), Random.FRandRange(-2000, 2000), 0);
+		HitboxSets[i].Build(FTransform(FRotator(0, Random.FRandRange(-180, 180), 0), Location), Definitions);
+	}
+
+	for (const FPlayerHitboxSet& Set : HitboxSets)
+	{
+		HitboxSetPtrs.Add(&Set);
+	}
+
+	//Aim every ray at a random character so a good portion of them hit
+	TArray<FHitboxRay> Rays;
+	Rays.SetNum(NumRays);
+
+	for (FHitboxRay& Ray : Rays)
+	{
+		const FPlayerHitboxSet& Target = HitboxSets[Random.RandHelper(NumCharacters)];
+		const FVector TargetPoint(Target.StartX[1], Target.StartY[1], Random.FRandRange(0, 190));
+
+		Ray.Start = FVector(Random.FRandRange(-3000, 3000), Random.FRandRange(-3000, 3000), 160);
+		Ray.End = Ray.Start + (TargetPoint - Ray.Start).GetSafeNormal() * 10000;
+	}
+
+	TArray<FHitboxRayResult> SimdResults;
+	TArray<FHitboxRayResult> ScalarResults;
+	SimdResults.SetNum(NumRays);
+	ScalarResults.SetNum(NumRays);
+
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < Iterations; i++)
+	{
+		HitboxKernel::RaycastHitboxes(Rays.GetData(), NumRays, HitboxSetPtrs.GetData(), NumCharacters, SimdResults.GetData());
+	}
+	const double SimdTime = FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < Iterations; i++)
+	{
+		HitboxKernel::RaycastHitboxesScalar(Rays.GetData(), NumRays, HitboxSetPtrs.GetData(), NumCharacters, ScalarResults.GetData());
+	}
+	const double ScalarTime = FPlatformTime::Seconds() - StartTime;
+
+	int32 NumHits = 0;
+	int32 NumMismatches = 0;
+
+	for (int32 i = 0; i < NumRays; i++)
+	{
+		NumHits += SimdResults[i].Region != EHitboxRegion::HR_None ? 1 : 0;
+
+		if (SimdResults[i].Region != ScalarResults[i].Region || SimdResults[i].HitboxSetIndex != ScalarResults[i].HitboxSetIndex)
+		{
+			NumMismatches++;
+		}
+	}
+
+	const double TotalRays = (double)NumRays * Iterations;
+
+	UE_LOG(LogWesternWar, Log, TEXT("Hitbox Benchmark | Rays: %d | Characters: %d | Iterations: %d | Hits: %d | Mismatches: %d"),
+		NumRays, NumCharacters, Iterations, NumHits, NumMismatches);
+	UE_LOG(LogWesternWar, Log, TEXT("Hitbox Benchmark | SIMD: %.1f ns per ray | Scalar: %.1f ns per ray | Speed Up: %.2fx"),
+		SimdTime / TotalRays * 1e9, ScalarTime / TotalRays * 1e9, SimdTime > 0 ? ScalarTime / SimdTime : 0);
+}
+
+static FAutoConsoleCommand HitboxBenchmarkCommand(
+	TEXT("ww.HitboxBenchmark"),
+	TEXT("Benchmark the ray vs hitbox capsule kernels. Usage: ww.HitboxBenchmark [NumRays] [NumCharacters] [Iterations]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&RunHitboxKernelBenchmark)
+	);
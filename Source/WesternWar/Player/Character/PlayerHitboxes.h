@@ -0,0 +1,94 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#pragma once
+
+#include "PlayerHitboxes.generated.h"
+
+#define MAX_PLAYER_HITBOXES 8	//Two SIMD lanes of 4, unused slots never register a hit
+
+UENUM(BlueprintType)
+namespace EHitboxRegion
+{
+	enum Type
+	{
+		HR_None,
+		HR_Head,
+		HR_Body,
+		HR_Arm,
+		HR_Leg,
+	};
+}
+
+USTRUCT(BlueprintType)
+struct FHitboxCapsuleDefinition
+{
+	//Capsule relative to the character root, used to build the world space hitboxes of a character
+
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitbox")
+		FVector LocalStart = FVector::ZeroVector;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitbox")
+		FVector LocalEnd = FVector::ZeroVector;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitbox")
+		float Radius = 10;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitbox")
+		TEnumAsByte<EHitboxRegion::Type> Region = EHitboxRegion::HR_Body;
+
+	FHitboxCapsuleDefinition() {}
+
+	FHitboxCapsuleDefinition(FVector InLocalStart, FVector InLocalEnd, float InRadius, EHitboxRegion::Type InRegion)
+		: LocalStart(InLocalStart), LocalEnd(InLocalEnd), Radius(InRadius), Region(InRegion)
+	{
+	}
+};
+
+/*
+* World space hitbox capsules of a character at one simulation step
+* - Stored as structure of arrays so the batch kernel can load 4 capsules per SIMD register
+* - Stored in the lag compensation history, so hits can be resolved without moving the character
+*/
+struct FPlayerHitboxSet
+{
+	float StartX[MAX_PLAYER_HITBOXES];
+	float StartY[MAX_PLAYER_HITBOXES];
+	float StartZ[MAX_PLAYER_HITBOXES];
+	float EndX[MAX_PLAYER_HITBOXES];
+	float EndY[MAX_PLAYER_HITBOXES];
+	float EndZ[MAX_PLAYER_HITBOXES];
+	float RadiusSquared[MAX_PLAYER_HITBOXES];	//Negative for unused slots
+	uint8 Region[MAX_PLAYER_HITBOXES];
+
+	FPlayerHitboxSet();
+
+	void Build(const FTransform& CharacterTransform, const TArray<FHitboxCapsuleDefinition>& Definitions);
+};
+
+struct FHitboxRay
+{
+	FVector Start;
+	FVector End;
+	int32 IgnoredHitboxSetIndex = INDEX_NONE;	//Hitbox set this ray never hits (the attacker of a melee swing)
+};
+
+struct FHitboxRayResult
+{
+	EHitboxRegion::Type Region = EHitboxRegion::HR_None;
+	int32 HitboxSetIndex = INDEX_NONE;	//Index of the hitbox set (character) that was hit
+	float Time = 1;	//Normalised position along the ray where it enters the hit capsule
+};
+
+/*
+* Ray vs Capsule batch kernel
+* - Tests every ray against every capsule of every hitbox set & returns the closest region hit per ray
+* - The ignored hitbox set of a ray is skipped, so one batch can hold rays of different attackers
+* - RaycastHitboxes uses SIMD registers (4 capsules per test), RaycastHitboxesScalar is the reference version
+*/
+namespace HitboxKernel
+{
+	void RaycastHitboxes(const FHitboxRay* Rays, int32 NumRays, const FPlayerHitboxSet* const* HitboxSets, int32 NumHitboxSets, FHitboxRayResult* OutResults);
+	void RaycastHitboxesScalar(const FHitboxRay* Rays, int32 NumRays, const FPlayerHitboxSet* const* HitboxSets, int32 NumHitboxSets, FHitboxRayResult* OutResults);
+
+	//Default capsule layout for a character with its root at the feet
+	void GetDefaultHitboxDefinitions(TArray<FHitboxCapsuleDefinition>& OutDefinitions);
+}
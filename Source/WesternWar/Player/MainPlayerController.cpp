@@ -2,7 +2,499 @@
 
 #include "WesternWar.h"
 #include "MainPlayerController.h"
+#include "Interfaces/ItemInterface.h"
+#include "Weapons/ProjectileWeapon.h"
+#include "Weapons/MeleeWeapon.h"
+#include "GameManager/MainGameState.h"
+#include "Player/Character/PlayerCharacter.h"
+#include "Networking/NetTrafficStats.h"
 
+//ww.Bot <Pattern|Off> [ScriptFile]
+static void RunBotCommand(const TArray<FString>& Args, UWorld* World)
+{
+	AMainPlayerController* PlayerController = World ? Cast<AMainPlayerController>(UGameplayStatics::GetPlayerController(World, 0)) : nullptr;
 
+	if (!PlayerController || Args.Num() < 1)
+	{
+		UE_LOG(LogWesternWar, Warning, TEXT("Usage: ww.Bot <Strafe|RandomWalk|FireBursts|Script|Off> [ScriptFile]"));
+		return;
+	}
 
+	PlayerController->StartBot(AMainPlayerController::ParseBotPattern(Args[0]), Args.Num() > 1 ? Args[1] : FString());
+}
 
+static FAutoConsoleCommandWithWorldAndArgs BotCommand(
+	TEXT("ww.Bot"),
+	TEXT("Drive the local player with synthetic input. Usage: ww.Bot <Strafe|RandomWalk|FireBursts|Script|Off> [ScriptFile]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunBotCommand));
+
+void AMainPlayerController::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (!IsLocalPlayerController())
+	{
+		return;
+	}
+
+	FString PatternName;
+	FString ScriptPath;
+
+	if (FParse::Value(FCommandLine::Get(), TEXT("wwbotscript="), ScriptPath))
+	{
+		StartBot(EBotInputPattern::Script, ScriptPath);
+	}
+	else if (FParse::Value(FCommandLine::Get(), TEXT("wwbot="), PatternName))
+	{
+		StartBot(ParseBotPattern(PatternName));
+	}
+}
+
+EBotInputPattern::Type AMainPlayerController::ParseBotPattern(const FString& PatternName)
+{
+	if (PatternName == TEXT("Strafe"))
+	{
+		return EBotInputPattern::Strafe;
+	}
+	else if (PatternName == TEXT("RandomWalk"))
+	{
+		return EBotInputPattern::RandomWalk;
+	}
+	else if (PatternName == TEXT("FireBursts"))
+	{
+		return EBotInputPattern::FireBursts;
+	}
+	else if (PatternName == TEXT("Script"))
+	{
+		return EBotInputPattern::Script;
+	}
+
+	return EBotInputPattern::None;
+}
+
+void AMainPlayerController::StartBot(EBotInputPattern::Type Pattern, const FString& ScriptPath)
+{
+	StopBot();
+
+	//Every bot process walks differently unless a seed is given
+	int32 Seed = FPlatformProcess::GetCurrentProcessId();
+	FParse::Value(FCommandLine::Get(), TEXT("wwbotseed="), Seed);
+	BotRandomStream.Initialize(Seed);
+
+	FBotInputStep Step;
+
+	switch (Pattern)
+	{
+	case EBotInputPattern::Strafe:
+		Step.Duration = 1.5f;
+		Step.HorizontalInput = 1;
+		Step.HorizontalLookInput = 0.5f;
+		BotSteps.Add(Step);
+		Step.HorizontalInput = -1;
+		BotSteps.Add(Step);
+		break;
+	case EBotInputPattern::FireBursts:
+		Step.Duration = 0.3f;
+		Step.bFire = true;
+		BotSteps.Add(Step);
+		Step.Duration = 1.2f;
+		Step.bFire = false;
+		Step.HorizontalLookInput = 1;
+		BotSteps.Add(Step);
+		break;
+	case EBotInputPattern::Script:
+		if (!LoadBotScript(ScriptPath))
+		{
+			return;
+		}
+		break;
+	default:
+		break;
+	}
+
+	BotPattern = Pattern;
+	BotStepIndex = -1;
+	AdvanceBotStep();
+
+	if (IsBot())
+	{
+		UE_LOG(LogWesternWar, Log, TEXT("Bot | %s started with pattern %d (seed %d)"), *GetName(), (int32)BotPattern, Seed);
+	}
+}
+
+void AMainPlayerController::StopBot()
+{
+	BotPattern = EBotInputPattern::None;
+	BotSteps.Empty();
+	CurrentBotStep = FBotInputStep();
+}
+
+bool AMainPlayerController::LoadBotScript(const FString& FilePath)
+{
+	TArray<FString> Lines;
+
+	if (!FFileHelper::LoadANSITextFileToStrings(*FilePath, nullptr, Lines))
+	{
+		UE_LOG(LogWesternWar, Warning, TEXT("Bot | Failed to load script %s"), *FilePath);
+		return false;
+	}
+
+	for (const FString& Line : Lines)
+	{
+		TArray<FString> Values;
+		Line.ParseIntoArrayWS(Values);
+
+		//Empty lines & comments
+		if (Values.Num() < 6 || Values[0].StartsWith(TEXT("#")))
+		{
+			continue;
+		}
+
+		FBotInputStep Step;
+		Step.Duration = FMath::Max(FCString::Atof(*Values[0]), 0.01f);
+		Step.VerticalInput = FCString::Atof(*Values[1]);
+		Step.HorizontalInput = FCString::Atof(*Values[2]);
+		Step.UpInput = FCString::Atof(*Values[3]);
+		Step.HorizontalLookInput = FCString::Atof(*Values[4]);
+		Step.bFire = FCString::Atoi(*Values[5]) != 0;
+		BotSteps.Add(Step);
+	}
+
+	if (BotSteps.Num() == 0)
+	{
+		UE_LOG(LogWesternWar, Warning, TEXT("Bot | Script %s has no steps"), *FilePath);
+		return false;
+	}
+
+	return true;
+}
+
+void AMainPlayerController::AdvanceBotStep()
+{
+	if (BotPattern == EBotInputPattern::RandomWalk)
+	{
+		CurrentBotStep.Duration = BotRandomStream.FRandRange(0.5f, 2.0f);
+		CurrentBotStep.VerticalInput = (float)BotRandomStream.RandRange(-1, 1);
+		CurrentBotStep.HorizontalInput = (float)BotRandomStream.RandRange(-1, 1);
+		CurrentBotStep.UpInput = BotRandomStream.FRand() < 0.1f ? 1.0f : 0.0f;
+		CurrentBotStep.HorizontalLookInput = BotRandomStream.FRandRange(-2.0f, 2.0f);
+		CurrentBotStep.bFire = BotRandomStream.FRand() < 0.2f;
+	}
+	else if (BotSteps.Num() > 0)
+	{
+		BotStepIndex = (BotStepIndex + 1) % BotSteps.Num();
+		CurrentBotStep = BotSteps[BotStepIndex];
+	}
+
+	BotStepTimeLeft = CurrentBotStep.Duration;
+}
+
+void AMainPlayerController::GetBotInput(float DeltaTime, FClientCharacterData& InOutCharacterData)
+{
+	BotStepTimeLeft -= DeltaTime;
+
+	if (BotStepTimeLeft <= 0)
+	{
+		AdvanceBotStep();
+	}
+
+	InOutCharacterData.VerticalInput = CurrentBotStep.VerticalInput;
+	InOutCharacterData.HorizontalInput = CurrentBotStep.HorizontalInput;
+	InOutCharacterData.UpInput = CurrentBotStep.UpInput;
+	InOutCharacterData.VerticalLookInput = 0;
+	InOutCharacterData.HorizontalLookInput = CurrentBotStep.HorizontalLookInput;
+
+	if (CurrentBotStep.bFire)
+	{
+		FireBotWeapons();
+	}
+}
+
+//Fires every weapon attached to the character, weapons decide themselves if they can fire
+void AMainPlayerController::FireBotWeapons()
+{
+	APawn* ControlledPawn = GetPawn();
+
+	if (!ControlledPawn)
+	{
+		return;
+	}
+
+	TArray<AActor*> AttachedActors;
+	ControlledPawn->GetAttachedActors(AttachedActors);
+
+	for (AActor* AttachedActor : AttachedActors)
+	{
+		if (AProjectileWeapon* ProjectileWeapon = Cast<AProjectileWeapon>(AttachedActor))
+		{
+			ProjectileWeapon->Fire();
+		}
+		else if (AMeleeWeapon* MeleeWeapon = Cast<AMeleeWeapon>(AttachedActor))
+		{
+			MeleeWeapon->Swing();
+		}
+	}
+}
+
+/*
+* -- World Items --
+*/
+
+void AMainPlayerController::PickUpItem(AActor* ItemActor)
+{
+	if (!ItemActor)
+	{
+		return;
+	}
+
+	Server_PickUpItem(ItemActor);
+	FNetTrafficStats::Get().RecordRpcSent(ENetRpc::Server_PickUpItem, NET_OBJECT_REFERENCE_BITS);
+}
+
+void AMainPlayerController::DropItem(AActor* ItemActor)
+{
+	if (!ItemActor)
+	{
+		return;
+	}
+
+	Server_DropItem(ItemActor);
+	FNetTrafficStats::Get().RecordRpcSent(ENetRpc::Server_DropItem, NET_OBJECT_REFERENCE_BITS);
+}
+
+bool AMainPlayerController::Server_PickUpItem_Validate(AActor* ItemActor)
+{
+	return true;
+}
+
+//Pickups out of reach or of items that are already taken are ignored
+void AMainPlayerController::Server_PickUpItem_Implementation(AActor* ItemActor)
+{
+	FNetTrafficStats::Get().RecordRpcReceived(ENetRpc::Server_PickUpItem, NET_OBJECT_REFERENCE_BITS);
+
+	UWorldItemRegistry* WorldItemRegistry = AMainGameState::GetWorldItemRegistry(this);
+	APawn* ControlledPawn = GetPawn();
+
+	if (!WorldItemRegistry || !ControlledPawn)
+	{
+		return;
+	}
+
+	AActor* PickedUpActor = WorldItemRegistry->PickUpItem(ControlledPawn, WorldItemRegistry->FindItemID(ItemActor));
+
+	if (!PickedUpActor)
+	{
+		return;
+	}
+
+	PickedUpActor->SetOwner(ControlledPawn);
+	PickedUpActor->AttachToActor(ControlledPawn, FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+
+	if (PickedUpActor->GetClass()->ImplementsInterface(UItemInterface::StaticClass()))
+	{
+		IItemInterface::Execute_PickUpItem(PickedUpActor);
+	}
+}
+
+bool AMainPlayerController::Server_DropItem_Validate(AActor* ItemActor)
+{
+	return true;
+}
+
+//Only items held by the controlled pawn can be dropped, they go back into the registry where they were dropped
+void AMainPlayerController::Server_DropItem_Implementation(AActor* ItemActor)
+{
+	FNetTrafficStats::Get().RecordRpcReceived(ENetRpc::Server_DropItem, NET_OBJECT_REFERENCE_BITS);
+
+	UWorldItemRegistry* WorldItemRegistry = AMainGameState::GetWorldItemRegistry(this);
+
+	if (!WorldItemRegistry || !ItemActor || !GetPawn() || ItemActor->GetOwner() != GetPawn())
+	{
+		return;
+	}
+
+	if (ItemActor->GetClass()->ImplementsInterface(UItemInterface::StaticClass()))
+	{
+		IItemInterface::Execute_ThrowItem(ItemActor);
+	}
+
+	WorldItemRegistry->AddItemActor(ItemActor);
+}
+
+/*
+* -- Killcam --
+*/
+
+void AMainPlayerController::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (bIsPlayingKillcam)
+	{
+		TickKillcamPlayback(DeltaSeconds);
+	}
+}
+
+void AMainPlayerController::SendKillcamClip(const TArray<APawn*>& ClipPawns, const TArray<uint8>& Clip)
+{
+	Client_BeginKillcamClip(ClipPawns, Clip.Num());
+	FNetTrafficStats::Get().RecordRpcSent(ENetRpc::Client_BeginKillcamClip, NET_ARRAY_NUM_BITS + ClipPawns.Num() * NET_OBJECT_REFERENCE_BITS + 32);
+
+	for (int32 Offset = 0; Offset < Clip.Num(); Offset += KILLCAM_CLIP_CHUNK_SIZE)
+	{
+		const int32 ChunkSize = FMath::Min(KILLCAM_CLIP_CHUNK_SIZE, Clip.Num() - Offset);
+
+		Client_ReceiveKillcamChunk(TArray<uint8>(Clip.GetData() + Offset, ChunkSize));
+		FNetTrafficStats::Get().RecordRpcSent(ENetRpc::Client_ReceiveKillcamChunk, NET_ARRAY_NUM_BITS + ChunkSize * 8);
+	}
+}
+
+void AMainPlayerController::Client_BeginKillcamClip_Implementation(const TArray<APawn*>& ClipPawns, int32 ClipSize)
+{
+	FNetTrafficStats::Get().RecordRpcReceived(ENetRpc::Client_BeginKillcamClip, NET_ARRAY_NUM_BITS + ClipPawns.Num() * NET_OBJECT_REFERENCE_BITS + 32);
+
+	if (bIsPlayingKillcam)
+	{
+		StopKillcamPlayback();
+	}
+
+	//Pawns that are destroyed or not relevant to this client arrive as nullptr & are not played back
+	KillcamPawns.Reset();
+
+	for (APawn* ClipPawn : ClipPawns)
+	{
+		KillcamPawns.Add(Cast<APlayerCharacter>(ClipPawn));
+	}
+
+	KillcamClip.Reset(ClipSize);
+	KillcamClipSize = ClipSize;
+}
+
+void AMainPlayerController::Client_ReceiveKillcamChunk_Implementation(const TArray<uint8>& Chunk)
+{
+	FNetTrafficStats::Get().RecordRpcReceived(ENetRpc::Client_ReceiveKillcamChunk, NET_ARRAY_NUM_BITS + Chunk.Num() * 8);
+
+	KillcamClip.Append(Chunk);
+
+	if (KillcamClipSize > 0 && KillcamClip.Num() >= KillcamClipSize)
+	{
+		StartKillcamPlayback();
+	}
+}
+
+void AMainPlayerController::StartKillcamPlayback()
+{
+	const bool bIsDecoded = FKillcamHistory::DecodeClip(KillcamClip, KillcamFrames);
+
+	KillcamClip.Empty();
+	KillcamClipSize = 0;
+
+	if (!bIsDecoded)
+	{
+		UE_LOG(LogWesternWar, Warning, TEXT("Killcam | Received clip could not be decoded"));
+		return;
+	}
+
+	for (const TWeakObjectPtr<APlayerCharacter>& KillcamPawn : KillcamPawns)
+	{
+		if (KillcamPawn.IsValid())
+		{
+			KillcamPawn->BeginKillcamPlayback();
+		}
+	}
+
+	KillcamFrameIndex = 0;
+	KillcamPlaybackTime = 0;
+	bIsPlayingKillcam = true;
+}
+
+static const FKillcamPawnState* FindKillcamPawnState(const FKillcamFrame& Frame, int32 PawnIndex)
+{
+	for (const FKillcamPawnState& PawnState : Frame.Pawns)
+	{
+		if (PawnState.PawnIndex == PawnIndex)
+		{
+			return &PawnState;
+		}
+	}
+
+	return nullptr;
+}
+
+/*
+* Plays the recorded frames on their recorded server times
+* - The pawns are posed between the two frames around the playback time, so uneven frame spacing & any frame rate play back at the recorded speed
+* - Fire events are sent once the playback time reaches their frame
+*/
+void AMainPlayerController::TickKillcamPlayback(float DeltaSeconds)
+{
+	KillcamPlaybackTime += DeltaSeconds;
+
+	const float PlaybackServerTime = KillcamFrames[0].ServerTime + KillcamPlaybackTime;
+
+	for (; KillcamFrameIndex < KillcamFrames.Num() && KillcamFrames[KillcamFrameIndex].ServerTime <= PlaybackServerTime; KillcamFrameIndex++)
+	{
+		for (const FKillcamFireEvent& FireEvent : KillcamFrames[KillcamFrameIndex].FireEvents)
+		{
+			OnKillcamFireEvent(GetKillcamPawn(FireEvent.PawnIndex), FireEvent.Origin, FireEvent.Direction);
+		}
+	}
+
+	const FKillcamFrame& FromFrame = KillcamFrames[FMath::Max(KillcamFrameIndex - 1, 0)];
+	const FKillcamFrame& ToFrame = KillcamFrames[FMath::Min(KillcamFrameIndex, KillcamFrames.Num() - 1)];
+
+	const float FrameTime = ToFrame.ServerTime - FromFrame.ServerTime;
+	const float Alpha = FrameTime > 0 ? FMath::Clamp((PlaybackServerTime - FromFrame.ServerTime) / FrameTime, 0.0f, 1.0f) : 1;
+
+	for (const FKillcamPawnState& FromState : FromFrame.Pawns)
+	{
+		APlayerCharacter* PlayerCharacter = GetKillcamPawn(FromState.PawnIndex);
+
+		if (!PlayerCharacter)
+		{
+			continue;
+		}
+
+		//A pawn missing from the next frame has left its slot, it is held at its last recorded state
+		const FKillcamPawnState* ToState = FindKillcamPawnState(ToFrame, FromState.PawnIndex);
+
+		if (!ToState)
+		{
+			ToState = &FromState;
+		}
+
+		const FVector Location = FMath::Lerp(FromState.Location, ToState->Location, Alpha);
+		const FRotator Rotation = FMath::Lerp(FRotator(0, FromState.Yaw, 0), FRotator(0, ToState->Yaw, 0), Alpha);
+
+		PlayerCharacter->SetKillcamPose(Location, Rotation);
+	}
+
+	//The last frame has been posed, hand the characters back to replication
+	if (KillcamFrameIndex >= KillcamFrames.Num())
+	{
+		StopKillcamPlayback();
+	}
+}
+
+APlayerCharacter* AMainPlayerController::GetKillcamPawn(int32 PawnIndex) const
+{
+	return KillcamPawns.IsValidIndex(PawnIndex) ? KillcamPawns[PawnIndex].Get() : nullptr;
+}
+
+void AMainPlayerController::StopKillcamPlayback()
+{
+	for (const TWeakObjectPtr<APlayerCharacter>& KillcamPawn : KillcamPawns)
+	{
+		if (KillcamPawn.IsValid())
+		{
+			KillcamPawn->EndKillcamPlayback();
+		}
+	}
+
+	KillcamPawns.Empty();
+
+	KillcamFrames.Empty();
+	bIsPlayingKillcam = false;
+
+	OnKillcamFinished();
+}
@@ -3,17 +3,110 @@
 #pragma once
 
 #include "GameFramework/PlayerController.h"
+#include "Player/Character/CharacterNetData.h"
+#include "Networking/KillcamHistory.h"
 #include "MainPlayerController.generated.h"
 
+namespace EBotInputPattern
+{
+	enum Type
+	{
+		None,
+		Strafe,		//Strafes left & right while turning slowly
+		RandomWalk,	//Random movement, turning, jumping & firing for random durations
+		FireBursts,	//Stands still & fires short bursts while turning
+		Script,		//Steps loaded from a text file, looped
+	};
+}
+
+struct FBotInputStep
+{
+	float Duration = 1;
+	float VerticalInput = 0;
+	float HorizontalInput = 0;
+	float UpInput = 0;
+	float HorizontalLookInput = 0;
+	bool bFire = false;
+};
+
 /**
- * 
+ * Bot Mode - synthetic input for server load testing
+ * - The possessed character takes the bot input as its move input, so it goes through the same prediction & RPC path as a player
+ * - Started with -wwbot=<Strafe|RandomWalk|FireBursts> or -wwbotscript=<File> on the command line, or ww.Bot in the console
+ * - Script files have one step per line: <Seconds> <Vertical> <Horizontal> <Up> <Turn> <Fire>
+ * - Dozens of headless bots: WesternWar.exe 127.0.0.1 -game -nullrhi -nosound -wwbot=RandomWalk
  */
 UCLASS()
 class WESTERNWAR_API AMainPlayerController : public APlayerController
 {
 	GENERATED_BODY()
 	
-	
-	
+private:
+	EBotInputPattern::Type BotPattern = EBotInputPattern::None;
+	TArray<FBotInputStep> BotSteps;
+	FBotInputStep CurrentBotStep;
+	int32 BotStepIndex = 0;
+	float BotStepTimeLeft = 0;
+	FRandomStream BotRandomStream;
+
+	void AdvanceBotStep();
+	void FireBotWeapons();
+	bool LoadBotScript(const FString& FilePath);
+
+	//Killcam playback (client)
+	TArray<uint8> KillcamClip;
+	int32 KillcamClipSize = 0;
+	TArray<FKillcamFrame> KillcamFrames;
+	TArray<TWeakObjectPtr<class APlayerCharacter>> KillcamPawns;	//Pawns of the clip, indexed by the recorded pawn index
+	int32 KillcamFrameIndex = 0;	//Frames reached by the playback time
+	float KillcamPlaybackTime = 0;
+	bool bIsPlayingKillcam = false;
+
+	void StartKillcamPlayback();
+	void TickKillcamPlayback(float DeltaSeconds);
+	void StopKillcamPlayback();
+	class APlayerCharacter* GetKillcamPawn(int32 PawnIndex) const;
+
+	//Networking Functions
+	UFUNCTION(Client, Reliable)
+		void Client_BeginKillcamClip(const TArray<APawn*>& ClipPawns, int32 ClipSize);
+	UFUNCTION(Client, Reliable)
+		void Client_ReceiveKillcamChunk(const TArray<uint8>& Chunk);
+	UFUNCTION(Server, Reliable, WithValidation)
+		void Server_PickUpItem(AActor* ItemActor);
+	UFUNCTION(Server, Reliable, WithValidation)
+		void Server_DropItem(AActor* ItemActor);
+
+public:
+	virtual void BeginPlay() override;
+	virtual void Tick(float DeltaSeconds) override;
+
+	void StartBot(EBotInputPattern::Type Pattern, const FString& ScriptPath = FString());
+	void StopBot();
+
+	bool IsBot() const { return BotPattern != EBotInputPattern::None; }
+
+	//Overwrites the move input with the current bot step, called by the possessed character before every move
+	void GetBotInput(float DeltaTime, FClientCharacterData& InOutCharacterData);
+
+	static EBotInputPattern::Type ParseBotPattern(const FString& PatternName);
+
+	//World items - the server validates the pickup against the world item registry
+	UFUNCTION(BlueprintCallable, Category = "World Items")
+		void PickUpItem(AActor* ItemActor);
+	UFUNCTION(BlueprintCallable, Category = "World Items")
+		void DropItem(AActor* ItemActor);
+
+	//Server - streams a killcam clip to this players client in reliable chunks
+	void SendKillcamClip(const TArray<APawn*>& ClipPawns, const TArray<uint8>& Clip);
+
+	UFUNCTION(BlueprintCallable, Category = "Killcam")
+		bool IsPlayingKillcam() const { return bIsPlayingKillcam; }
+
+	//Recorded shots during killcam playback, for tracers & muzzle flashes
+	UFUNCTION(BlueprintImplementableEvent, Category = "Killcam")
+		void OnKillcamFireEvent(APawn* Shooter, FVector Origin, FVector Direction);
+	UFUNCTION(BlueprintImplementableEvent, Category = "Killcam")
+		void OnKillcamFinished();
 	
 };
@@ -2,7 +2,131 @@
 
 #include "WesternWar.h"
 #include "MainPlayerState.h"
+#include "UnrealNetwork.h"
 
+AMainPlayerState::AMainPlayerState()
+{
+}
 
+void AMainPlayerState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
+	//Only the owning client uses its own network quality
+	DOREPLIFETIME_CONDITION(AMainPlayerState, SmoothedRTT, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(AMainPlayerState, Jitter, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(AMainPlayerState, PacketLoss, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(AMainPlayerState, CorrectionRate, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(AMainPlayerState, LagCompensationWindow, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(AMainPlayerState, ExtraInterpolationDelay, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(AMainPlayerState, InputRedundancy, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(AMainPlayerState, OwnerUpdateRateScale, COND_OwnerOnly);
+}
 
+void AMainPlayerState::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (Role == ROLE_Authority)
+	{
+		GetWorldTimerManager().SetTimer(NetworkQualityTimerHandle, this, &AMainPlayerState::UpdateNetworkQuality, NetworkQualityUpdateInterval, true);
+	}
+}
+
+void AMainPlayerState::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GetWorldTimerManager().ClearTimer(NetworkQualityTimerHandle);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AMainPlayerState::RecordMoveResult(bool bWasCorrected)
+{
+	if (bWasCorrected)
+	{
+		MovesCorrected++;
+	}
+	else
+	{
+		MovesAcknowledged++;
+	}
+}
+
+/*
+* Samples the connection of the owning player controller
+* - RTT & jitter are exponential moving averages, loss is the ratio of the connections per stat period packet counters
+*/
+void AMainPlayerState::UpdateNetworkQuality()
+{
+	APlayerController* OwnerController = Cast<APlayerController>(GetOwner());
+	UNetConnection* Connection = OwnerController ? OwnerController->GetNetConnection() : nullptr;
+
+	//Local players (listen server host) have no connection to measure
+	if (Connection)
+	{
+		const float RTTSample = Connection->AvgLag * 1000;
+
+		if (SmoothedRTT == 0)
+		{
+			SmoothedRTT = RTTSample;
+		}
+
+		Jitter = FMath::Lerp(Jitter, FMath::Abs(RTTSample - SmoothedRTT), 0.25f);
+		SmoothedRTT = FMath::Lerp(SmoothedRTT, RTTSample, 0.125f);
+
+		const int32 PacketsLost = Connection->InPacketsLost + Connection->OutPacketsLost;
+		const int32 Packets = Connection->InPackets + Connection->OutPackets + PacketsLost;
+
+		if (Packets > 0)
+		{
+			PacketLoss = FMath::Lerp(PacketLoss, (float)PacketsLost / Packets, 0.25f);
+		}
+	}
+
+	const int32 MoveResults = MovesAcknowledged + MovesCorrected;
+
+	if (MoveResults > 0)
+	{
+		CorrectionRate = FMath::Lerp(CorrectionRate, (float)MovesCorrected / MoveResults, 0.25f);
+		MovesAcknowledged = 0;
+		MovesCorrected = 0;
+	}
+
+	UpdateAdaptiveSettings();
+}
+
+void AMainPlayerState::UpdateAdaptiveSettings()
+{
+	//Jitter & lost updates leave gaps in the interpolation buffer, buffer enough to cover them
+	ExtraInterpolationDelay = FMath::Min(Jitter * 2 / 1000 + PacketLoss * 0.5f, MaxExtraInterpolationDelay);
+
+	//The pawns the player shoots at are shown behind by the interpolation buffer on top of the connection delay
+	const AController* OwnerController = Cast<AController>(GetOwner());
+	const APawn* OwnerPawn = OwnerController ? OwnerController->GetPawn() : nullptr;
+	const float InterpolationDelay = OwnerPawn && OwnerPawn->NetUpdateFrequency > 0 ? GetInterpolationBufferSize(OwnerPawn->NetUpdateFrequency) / OwnerPawn->NetUpdateFrequency : 0;
+
+	//Rewind as far as the players view is behind the server, never further than the cap (limits how far victims can be hit behind cover)
+	LagCompensationWindow = FMath::Min((SmoothedRTT + Jitter) / 1000 + InterpolationDelay + 0.1f, MaxLagCompensationWindow);
+
+	//One extra copy of the previous moves per ~3% of packets lost
+	InputRedundancy = (uint8)FMath::Clamp(FMath::CeilToInt(PacketLoss / 0.03f), 0, MAX_INPUT_REDUNDANCY);
+
+	//Congested links get fewer owner updates, frequent corrections keep the full rate so errors are fixed quickly
+	if ((SmoothedRTT > 200 || PacketLoss > 0.1f) && CorrectionRate < 0.2f)
+	{
+		OwnerUpdateRateScale = 0.5f;
+	}
+	else if (SmoothedRTT > 120 || PacketLoss > 0.05f)
+	{
+		OwnerUpdateRateScale = 0.75f;
+	}
+	else
+	{
+		OwnerUpdateRateScale = 1;
+	}
+}
+
+int32 AMainPlayerState::GetInterpolationBufferSize(float UpdateFrequency) const
+{
+	return 2 + FMath::CeilToInt(ExtraInterpolationDelay * UpdateFrequency);
+}
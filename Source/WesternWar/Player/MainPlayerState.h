@@ -5,15 +5,67 @@
 #include "GameFramework/PlayerState.h"
 #include "MainPlayerState.generated.h"
 
+#define MAX_INPUT_REDUNDANCY 3
+
 /**
- * 
+ * Network quality of the player & the netcode settings derived from it
+ * - Measured on the server from the players connection & move corrections, replicated to the owning client only
+ * - Good links keep the low latency settings, lossy or jittery links get redundant input, a deeper interpolation buffer
+ *   & a lower owner update rate, the lag compensation window is capped by the players latency
  */
 UCLASS()
 class WESTERNWAR_API AMainPlayerState : public APlayerState
 {
 	GENERATED_BODY()
 	
-	
-	
+private:
+	FTimerHandle NetworkQualityTimerHandle;
+
+	int32 MovesAcknowledged = 0;
+	int32 MovesCorrected = 0;
+
+	void UpdateNetworkQuality();
+	void UpdateAdaptiveSettings();
+
+public:
+	AMainPlayerState();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	//Measured (server)
+	UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly, Category = "Network Quality")
+		float SmoothedRTT = 0;	//Milliseconds
+	UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly, Category = "Network Quality")
+		float Jitter = 0;	//Milliseconds, smoothed deviation of the RTT
+	UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly, Category = "Network Quality")
+		float PacketLoss = 0;	//0 - 1, in & out packets
+	UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly, Category = "Network Quality")
+		float CorrectionRate = 0;	//0 - 1, fraction of owner updates that were corrections
+
+	//Adaptive settings
+	UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly, Category = "Network Quality|Adaptive")
+		float LagCompensationWindow = 0.2f;	//Seconds the server rewinds at most for this players shots
+	UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly, Category = "Network Quality|Adaptive")
+		float ExtraInterpolationDelay = 0;	//Seconds added to the interpolation buffer of the pawns this player sees
+	UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly, Category = "Network Quality|Adaptive")
+		uint8 InputRedundancy = 0;	//Previous moves resent with every move
+	UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly, Category = "Network Quality|Adaptive")
+		float OwnerUpdateRateScale = 1;	//Scale of the acknowledgement / correction rate sent to this player
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network Quality|Limits")
+		float MaxLagCompensationWindow = 0.5f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network Quality|Limits")
+		float MaxExtraInterpolationDelay = 0.15f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network Quality|Limits")
+		float NetworkQualityUpdateInterval = 0.5f;
+
+	//Server - called for every acknowledgement or correction sent to the owning client
+	void RecordMoveResult(bool bWasCorrected);
+
+	//Snapshots the pawns this player sees should keep buffered at the given update frequency
+	int32 GetInterpolationBufferSize(float UpdateFrequency) const;
+
+	bool IsWithinLagCompensationWindow(float RewindSeconds) const { return RewindSeconds <= LagCompensationWindow; }
 	
 };
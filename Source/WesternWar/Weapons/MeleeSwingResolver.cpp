@@ -0,0 +1,210 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#include "WesternWar.h"
+#include "MeleeSwingResolver.h"
+#include "MeleeWeapon.h"
+#include "GameManager/WorldSnapshotHistory.h"
+#include "Player/Character/PlayerCharacter.h"
+#include "Networking/NetcodeTimingStats.h"
+
+void FMeleeSwingResolver::ResolveSwings(int32 ServerTick, float ServerTime, const FWorldSnapshotHistory& SnapshotHistory)
+{
+	if (ActiveSwings.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_NETCODE_TIMER(STAT_ResolveMeleeSwings, nullptr);
+
+	Rays.Reset();
+	RaySwingIndices.Reset();
+	RayHistoryTicks.Reset();
+
+	for (int32 SwingIndex = 0; SwingIndex < ActiveSwings.Num(); SwingIndex++)
+	{
+		AddSwingSegmentRays(SwingIndex, ServerTick, ServerTime, SnapshotHistory);
+	}
+
+	//One kernel call per distinct history tick, swings that started together share their hitboxes
+	for (int32 RayIndex = 0; RayIndex < Rays.Num(); RayIndex++)
+	{
+		const int32 HistoryTick = RayHistoryTicks[RayIndex];
+
+		if (HistoryTick != INDEX_NONE)
+		{
+			ResolveHistoryTick(HistoryTick, SnapshotHistory);
+		}
+	}
+
+	//Finished swings & swings of weapons that no longer exist
+	for (int32 SwingIndex = ActiveSwings.Num() - 1; SwingIndex >= 0; SwingIndex--)
+	{
+		const FMeleeSwing& Swing = ActiveSwings[SwingIndex];
+		const AMeleeWeapon* Weapon = Swing.Weapon.Get();
+
+		if (!Weapon || Swing.SegmentsResolved >= FMath::Clamp(Weapon->NumSwingSegments, 1, MAX_MELEE_SWING_SEGMENTS))
+		{
+			ActiveSwings.RemoveAtSwap(SwingIndex);
+		}
+	}
+}
+
+/*
+* Adds a ray for every segment of the swing that is due by the server time
+* - The first & last segment are the edges of the arc, the segments in between are spread evenly over the swing duration
+* - The history tick advances with the swing, so the targets move the way the attacker saw them move
+* - Every ray is shortened to the first static world geometry it hits, same as the shot ray of a gun
+*/
+void FMeleeSwingResolver::AddSwingSegmentRays(int32 SwingIndex, int32 ServerTick, float ServerTime, const FWorldSnapshotHistory& SnapshotHistory)
+{
+	FMeleeSwing& Swing = ActiveSwings[SwingIndex];
+	const AMeleeWeapon* Weapon = Swing.Weapon.Get();
+
+	if (!Weapon)
+	{
+		return;
+	}
+
+	const int32 NumSegments = FMath::Clamp(Weapon->NumSwingSegments, 1, MAX_MELEE_SWING_SEGMENTS);
+	const float SwingAlpha = Weapon->SwingDuration > 0 ? (ServerTime - Swing.StartTime) / Weapon->SwingDuration : 1;
+	const int32 SegmentsDue = NumSegments > 1 ? FMath::Min(FMath::FloorToInt(SwingAlpha * (NumSegments - 1)) + 1, NumSegments) : 1;
+
+	int32 HistoryTick = FMath::Min(Swing.RewindTick + (ServerTick - Swing.StartTick), ServerTick);
+
+	if (!SnapshotHistory.HasTick(HistoryTick))
+	{
+		HistoryTick = SnapshotHistory.GetNewestTick();
+	}
+
+	FCollisionQueryParams TraceParams(FName(TEXT("Melee Swing Trace")), false, Weapon);
+	TraceParams.AddIgnoredActor(Weapon->GetOwner());
+
+	for (; Swing.SegmentsResolved < SegmentsDue; Swing.SegmentsResolved++)
+	{
+		const float SegmentAlpha = NumSegments > 1 ? (float)Swing.SegmentsResolved / (NumSegments - 1) : 0.5f;
+		const float SegmentAngle = FMath::Lerp(-Weapon->SwingArcAngle / 2, Weapon->SwingArcAngle / 2, SegmentAlpha);
+		const FVector SegmentDirection = Swing.Direction.RotateAngleAxis(SegmentAngle, FVector::UpVector);
+
+		FHitboxRay Ray;
+		Ray.Start = Swing.Origin + SegmentDirection * Weapon->SwingInnerRadius;
+		Ray.End = Swing.Origin + SegmentDirection * Weapon->SwingRange;
+
+		FHitResult WorldHit(ForceInit);
+
+		if (Weapon->GetWorld()->LineTraceSingleByObjectType(WorldHit, Ray.Start, Ray.End, FCollisionObjectQueryParams(ECC_WorldStatic), TraceParams))
+		{
+			Ray.End = WorldHit.ImpactPoint;
+		}
+
+		Rays.Add(Ray);
+		RaySwingIndices.Add(SwingIndex);
+		RayHistoryTicks.Add(HistoryTick);
+	}
+}
+
+/*
+* Tests every ray of the history tick against the hitboxes of the pawns in reach of them
+* - Every ray ignores the hitbox set of its own attacker, so the whole group is one kernel call
+*/
+void FMeleeSwingResolver::ResolveHistoryTick(int32 HistoryTick, const FWorldSnapshotHistory& SnapshotHistory)
+{
+	GroupRays.Reset();
+	GroupRayIndices.Reset();
+
+	float MaxReachSquared = 0;
+
+	for (int32 RayIndex = 0; RayIndex < Rays.Num(); RayIndex++)
+	{
+		if (RayHistoryTicks[RayIndex] == HistoryTick)
+		{
+			GroupRays.Add(Rays[RayIndex]);
+			GroupRayIndices.Add(RayIndex);
+			RayHistoryTicks[RayIndex] = INDEX_NONE;
+
+			const AMeleeWeapon* Weapon = ActiveSwings[RaySwingIndices[RayIndex]].Weapon.Get();
+
+			if (Weapon)
+			{
+				MaxReachSquared = FMath::Max(MaxReachSquared, FMath::Square(Weapon->SwingRange + 200));
+			}
+		}
+	}
+
+	//Broad phase - only pawns near the origin of one of the swings get their hitboxes built
+	HitboxSets.SetNum(WORLD_SNAPSHOT_MAX_PAWNS, false);
+	HitboxSetPtrs.Reset();
+	HitboxSetSlots.Reset();
+
+	for (int32 Slot = 0; Slot < WORLD_SNAPSHOT_MAX_PAWNS; Slot++)
+	{
+		const FPawnSnapshot* Snapshot = SnapshotHistory.GetPawnSnapshot(HistoryTick, Slot);
+		const APlayerCharacter* Target = Snapshot ? Cast<APlayerCharacter>(SnapshotHistory.GetPawn(Slot)) : nullptr;
+
+		if (!Target)
+		{
+			continue;
+		}
+
+		bool bIsInReach = false;
+
+		for (int32 i = 0; i < GroupRayIndices.Num() && !bIsInReach; i++)
+		{
+			bIsInReach = FVector::DistSquared(ActiveSwings[RaySwingIndices[GroupRayIndices[i]]].Origin, Snapshot->Location) <= MaxReachSquared;
+		}
+
+		if (bIsInReach && Target->GetHitboxHistory(HistoryTick, HitboxSets[HitboxSetPtrs.Num()]))
+		{
+			HitboxSetPtrs.Add(&HitboxSets[HitboxSetPtrs.Num()]);
+			HitboxSetSlots.Add(Slot);
+		}
+	}
+
+	if (HitboxSetPtrs.Num() == 0)
+	{
+		return;
+	}
+
+	for (int32 i = 0; i < GroupRays.Num(); i++)
+	{
+		GroupRays[i].IgnoredHitboxSetIndex = HitboxSetSlots.IndexOfByKey(ActiveSwings[RaySwingIndices[GroupRayIndices[i]]].AttackerSlot);
+	}
+
+	GroupResults.SetNum(GroupRays.Num(), false);
+	HitboxKernel::RaycastHitboxes(GroupRays.GetData(), GroupRays.Num(), HitboxSetPtrs.GetData(), HitboxSetPtrs.Num(), GroupResults.GetData());
+
+	for (int32 i = 0; i < GroupRays.Num(); i++)
+	{
+		const int32 SwingIndex = RaySwingIndices[GroupRayIndices[i]];
+		FHitboxRayResult Result = GroupResults[i];
+
+		if (Result.HitboxSetIndex != INDEX_NONE)
+		{
+			Result.HitboxSetIndex = HitboxSetSlots[Result.HitboxSetIndex];
+			ApplyHit(SwingIndex, GroupRays[i], Result, SnapshotHistory);
+		}
+	}
+}
+
+//Result.HitboxSetIndex is the world snapshot slot of the hit pawn here
+void FMeleeSwingResolver::ApplyHit(int32 SwingIndex, const FHitboxRay& Ray, const FHitboxRayResult& Result, const FWorldSnapshotHistory& SnapshotHistory)
+{
+	FMeleeSwing& Swing = ActiveSwings[SwingIndex];
+	const uint64 SlotBit = (uint64)1 << Result.HitboxSetIndex;
+
+	if (Swing.HitSlots & SlotBit)
+	{
+		return;
+	}
+
+	AMeleeWeapon* Weapon = Swing.Weapon.Get();
+	APawn* HitPawn = SnapshotHistory.GetPawn(Result.HitboxSetIndex);
+
+	if (!Weapon || !HitPawn)
+	{
+		return;
+	}
+
+	Swing.HitSlots |= SlotBit;
+
+	Weapon->OnSwingHit(HitPawn, Result.Region, FMath::Lerp(Ray.Start, Ray.End, Result.Time), Swing.Direction);
+}
@@ -0,0 +1,61 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#pragma once
+
+#include "Player/Character/PlayerHitboxes.h"
+
+#define MAX_MELEE_SWING_SEGMENTS 32
+
+class AMeleeWeapon;
+class FWorldSnapshotHistory;
+
+struct FMeleeSwing
+{
+	TWeakObjectPtr<AMeleeWeapon> Weapon;
+	int32 AttackerSlot = INDEX_NONE;	//World snapshot slot of the attacker, never hit by its own swing
+	FVector Origin = FVector::ZeroVector;
+	FVector Direction = FVector::ForwardVector;
+	int32 StartTick = 0;	//Server tick the swing was received at
+	int32 RewindTick = 0;	//Server tick the attacker saw when the swing started
+	float StartTime = 0;	//Server time the swing was received at
+	int32 SegmentsResolved = 0;
+	uint64 HitSlots = 0;	//Bit per world snapshot slot already hit, every target is hit once per swing
+};
+
+/*
+* Melee Swing Resolver - advances every active melee swing & resolves their hits once per server tick
+* - Every segment of the arc is a ray from the inner radius to the range of the weapon at one angle of the arc
+* - Targets are the hitboxes built from the world snapshot history at the tick the attacker saw (advanced with the swing),
+*   so no live actor is moved & the weapon needs no overlap events
+* - All rays of the tick that rewind to the same tick are tested in one call of the hitbox kernel
+*/
+class WESTERNWAR_API FMeleeSwingResolver
+{
+private:
+	TArray<FMeleeSwing> ActiveSwings;
+
+	//Reused every tick so resolving does not allocate
+	TArray<FHitboxRay> Rays;
+	TArray<int32> RaySwingIndices;
+	TArray<int32> RayHistoryTicks;
+	TArray<FHitboxRay> GroupRays;
+	TArray<int32> GroupRayIndices;
+	TArray<FHitboxRayResult> GroupResults;
+	TArray<FPlayerHitboxSet> HitboxSets;
+	TArray<const FPlayerHitboxSet*> HitboxSetPtrs;
+	TArray<int32> HitboxSetSlots;
+
+	void AddSwingSegmentRays(int32 SwingIndex, int32 ServerTick, float ServerTime, const FWorldSnapshotHistory& SnapshotHistory);
+	void ResolveHistoryTick(int32 HistoryTick, const FWorldSnapshotHistory& SnapshotHistory);
+	void ApplyHit(int32 SwingIndex, const FHitboxRay& Ray, const FHitboxRayResult& Result, const FWorldSnapshotHistory& SnapshotHistory);
+
+public:
+	void AddSwing(const FMeleeSwing& Swing) { ActiveSwings.Add(Swing); }
+
+	//Sweeps the segments of every active swing that are due by the server time, called once per server tick after the snapshot is recorded
+	void ResolveSwings(int32 ServerTick, float ServerTime, const FWorldSnapshotHistory& SnapshotHistory);
+
+	int32 GetNumActiveSwings() const { return ActiveSwings.Num(); }
+
+	void Reset() { ActiveSwings.Empty(); }
+};
@@ -2,27 +2,201 @@
 
 #include "WesternWar.h"
 #include "MeleeWeapon.h"
+#include "MeleeSwingResolver.h"
+#include "GameManager/MainGameState.h"
+#include "Player/MainPlayerState.h"
+#include "Player/Character/PlayerCharacter.h"
+#include "Networking/NetTrafficStats.h"
 
 
 // Sets default values
 AMeleeWeapon::AMeleeWeapon()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	//Swings are resolved by AMainGameState, the weapon itself never ticks
+	PrimaryActorTick.bCanEverTick = false;
 
+	WeaponMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Weapon Mesh"));
+	WeaponMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	RootComponent = WeaponMesh;
+
+	bReplicates = true;
+
+}
+
+void AMeleeWeapon::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GetWorldTimerManager().ClearTimer(SwingTimerHandle);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+/*
+* Start a swing - the client only sends when & where it swung, hits are decided by the server
+* The server starts its own cooldown when it accepts the swing in Server_SendMeleeSwing
+*/
+void AMeleeWeapon::Swing()
+{
+	if (!bCanSwing)
+	{
+		return;
+	}
+
+	if (Role < ROLE_Authority)
+	{
+		bCanSwing = false;
+		GetWorldTimerManager().SetTimer(SwingTimerHandle, this, &AMeleeWeapon::FinishSwing, SwingCooldown, false);
+	}
+
+	FMeleeSwingData SwingData;
+	SwingData.SwingOrigin = GetActorLocation();
+	SwingData.SwingDirection = GetActorForwardVector();
+	SwingData.SwingStartTime = GetClientViewServerTime();
+
+	Server_SendMeleeSwing(SwingData);
+	FNetTrafficStats::Get().RecordRpcSent(ENetRpc::Server_SendMeleeSwing, FNetTrafficStats::GetSerializedBits(SwingData));
+}
+
+void AMeleeWeapon::FinishSwing()
+{
+	bCanSwing = true;
 }
 
-// Called when the game starts or when spawned
-void AMeleeWeapon::BeginPlay()
+float AMeleeWeapon::GetClientViewServerTime() const
 {
-	Super::BeginPlay();
-	
+	const AGameState* GameState = GetWorld()->GetGameState();
+
+	if (Role == ROLE_Authority || !GameState)
+	{
+		return GetWorld()->GetTimeSeconds();
+	}
+
+	float InterpolationDelay = 0;
+
+	const APawn* OwnerPawn = Cast<APawn>(GetOwner());
+	const AMainPlayerState* MainPlayerState = OwnerPawn ? Cast<AMainPlayerState>(OwnerPawn->PlayerState) : nullptr;
+
+	if (MainPlayerState && OwnerPawn->NetUpdateFrequency > 0)
+	{
+		InterpolationDelay = MainPlayerState->GetInterpolationBufferSize(OwnerPawn->NetUpdateFrequency) / OwnerPawn->NetUpdateFrequency;
+	}
+
+	return GameState->GetServerWorldTimeSeconds() - InterpolationDelay;
+}
+
+float AMeleeWeapon::GetDamageForRegion(EHitboxRegion::Type Region) const
+{
+	switch (Region)
+	{
+	case EHitboxRegion::HR_Head:
+		return HeadHitDamage;
+	case EHitboxRegion::HR_Body:
+		return BodyHitDamage;
+	case EHitboxRegion::HR_Arm:
+		return ArmHitDamage;
+	case EHitboxRegion::HR_Leg:
+		return LegHitDamage;
+	default:
+		return 0;
+	}
 }
 
-// Called every frame
-void AMeleeWeapon::Tick( float DeltaTime )
+void AMeleeWeapon::OnSwingHit(APawn* HitPawn, EHitboxRegion::Type Region, const FVector& HitLocation, const FVector& SwingDirection)
 {
-	Super::Tick( DeltaTime );
+	const APawn* OwnerPawn = Cast<APawn>(GetOwner());
 
+	FHitResult Hit(ForceInit);
+	Hit.Actor = HitPawn;
+	Hit.Location = HitLocation;
+	Hit.ImpactPoint = HitLocation;
+
+	UGameplayStatics::ApplyPointDamage(HitPawn, GetDamageForRegion(Region), SwingDirection, Hit, OwnerPawn ? OwnerPawn->GetController() : nullptr, this, UDamageType::StaticClass());
 }
 
+//INTERFACE FUNCTIONS
+
+bool AMeleeWeapon::UseItem_Implementation()
+{
+	return true;
+}
+
+bool AMeleeWeapon::PickUpItem_Implementation()
+{
+	return true;
+}
+
+bool AMeleeWeapon::ThrowItem_Implementation()
+{
+	return true;
+}
+
+void AMeleeWeapon::OnAcquiredFromPool_Implementation()
+{
+
+}
+
+//Reset the weapon so the next user of the pooled actor gets a fresh weapon
+void AMeleeWeapon::OnReturnedToPool_Implementation()
+{
+	bCanSwing = true;
+	GetWorldTimerManager().ClearTimer(SwingTimerHandle);
+}
+
+
+//NETWORKING FUNCTIONS
+
+bool AMeleeWeapon::Server_SendMeleeSwing_Validate(FMeleeSwingData SwingData)
+{
+	return !SwingData.SwingOrigin.ContainsNaN() && !SwingData.SwingDirection.ContainsNaN();
+}
+
+/*
+* Swings during the cooldown are ignored
+* - The swing is rewound to the time the attacker saw, capped by the attackers lag compensation window
+*/
+void AMeleeWeapon::Server_SendMeleeSwing_Implementation(FMeleeSwingData SwingData)
+{
+	FNetTrafficStats::Get().RecordRpcReceived(ENetRpc::Server_SendMeleeSwing, FNetTrafficStats::GetSerializedBits(SwingData));
+
+	AMainGameState* MainGameState = Cast<AMainGameState>(GetWorld()->GetGameState());
+
+	if (!bCanSwing || !MainGameState)
+	{
+		return;
+	}
+
+	bCanSwing = false;
+	GetWorldTimerManager().SetTimer(SwingTimerHandle, this, &AMeleeWeapon::FinishSwing, SwingCooldown, false);
+
+	APawn* OwnerPawn = Cast<APawn>(GetOwner());
+	const APlayerCharacter* OwnerCharacter = Cast<APlayerCharacter>(OwnerPawn);
+	const AMainPlayerState* MainPlayerState = OwnerPawn ? Cast<AMainPlayerState>(OwnerPawn->PlayerState) : nullptr;
+
+	const float ServerTime = GetWorld()->GetTimeSeconds();
+	float SwingStartTime = FMath::Min(SwingData.SwingStartTime, ServerTime);
+
+	if (MainPlayerState && !MainPlayerState->IsWithinLagCompensationWindow(ServerTime - SwingStartTime))
+	{
+		SwingStartTime = ServerTime - MainPlayerState->LagCompensationWindow;
+	}
+
+	FVector SwingOrigin = SwingData.SwingOrigin;
+
+	if (FVector::Dist(SwingOrigin, GetActorLocation()) > MaxSwingOriginError)
+	{
+		SwingOrigin = GetActorLocation();
+	}
+
+	const FWorldSnapshotHistory& SnapshotHistory = MainGameState->GetSnapshotHistory();
+	const int32 RewindTick = SnapshotHistory.FindTickForTime(SwingStartTime);
+
+	FMeleeSwing MeleeSwing;
+	MeleeSwing.Weapon = this;
+	MeleeSwing.AttackerSlot = OwnerCharacter ? OwnerCharacter->GetWorldSnapshotSlot() : INDEX_NONE;
+	MeleeSwing.Origin = SwingOrigin;
+	MeleeSwing.Direction = SwingData.SwingDirection.GetSafeNormal();
+	MeleeSwing.StartTick = MainGameState->GetServerTick();
+	MeleeSwing.RewindTick = RewindTick != INDEX_NONE ? RewindTick : MainGameState->GetServerTick();
+	MeleeSwing.StartTime = ServerTime;
+
+	MainGameState->GetMeleeSwingResolver().AddSwing(MeleeSwing);
+}
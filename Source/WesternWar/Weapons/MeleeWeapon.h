@@ -3,23 +3,113 @@
 #pragma once
 
 #include "GameFramework/Actor.h"
+#include "Interfaces/ItemInterface.h"
+#include "Interfaces/PooledActorInterface.h"
+#include "Player/Character/PlayerHitboxes.h"
 #include "MeleeWeapon.generated.h"
 
+USTRUCT()
+struct FMeleeSwingData
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY()
+		FVector SwingOrigin;
+	UPROPERTY()
+		FVector_NetQuantizeNormal SwingDirection;	//Center of the swing arc
+	UPROPERTY()
+		float SwingStartTime = 0;	//Server time of the world the attacker saw when the swing started
+};
+
+/*
+* Melee Weapon - server authoritative swept melee
+* - The client only sends the swing, the server sweeps the arc as rays against the hitboxes of the targets
+*   rewound to what the attacker saw, see FMeleeSwingResolver
+* - The weapon never ticks, active swings are advanced & resolved in one batch per server tick by AMainGameState
+*/
 UCLASS()
-class WESTERNWAR_API AMeleeWeapon : public AActor
+class WESTERNWAR_API AMeleeWeapon : public AActor, public IItemInterface, public IPooledActorInterface
 {
 	GENERATED_BODY()
+
+private:
+	void FinishSwing();
+
+	bool bCanSwing = true;
+
+	FTimerHandle SwingTimerHandle;
+
+	//Server time of the world the local player sees, other pawns are shown behind by the interpolation buffer
+	float GetClientViewServerTime() const;
+
+	//Networking Functions
+	UFUNCTION(Server, Unreliable, WithValidation)
+		void Server_SendMeleeSwing(FMeleeSwingData SwingData);
 	
 public:	
 	// Sets default values for this actor's properties
 	AMeleeWeapon();
 
-	// Called when the game starts or when spawned
-	virtual void BeginPlay() override;
-	
-	// Called every frame
-	virtual void Tick( float DeltaSeconds ) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	//Swings if the weapon can, UseItem stays free of side effects like on AProjectileWeapon
+	void Swing();
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "WeaponMesh")
+		UStaticMeshComponent *WeaponMesh;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon")
+		FString WeaponName;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon")
+		FString WeaponDescription;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon|Damage")
+		float HeadHitDamage = 60;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon|Damage")
+		float BodyHitDamage = 40;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon|Damage")
+		float ArmHitDamage = 30;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon|Damage")
+		float LegHitDamage = 30;
+
+	float GetDamageForRegion(EHitboxRegion::Type Region) const;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon|Swing")
+		float SwingDuration = 0.3f;	//Time the blade takes to cross the arc
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon|Swing")
+		float SwingCooldown = 0.6f;	//Time from the start of one swing to the next
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon|Swing")
+		float SwingArcAngle = 90;	//Degrees, centered on the swing direction
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon|Swing")
+		float SwingInnerRadius = 45;	//Start of the blade from the swing origin, keeps the attackers own hitboxes out of the arc
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon|Swing")
+		float SwingRange = 150;	//End of the blade from the swing origin
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon|Swing")
+		int32 NumSwingSegments = 8;	//Rays the arc is swept with, spread evenly over the swing duration
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon|Swing")
+		float MaxSwingOriginError = 150;	//Swing origins further than this from the attackers server location use the server location
+
+	//Server only - called by FMeleeSwingResolver once per target hit by a swing
+	void OnSwingHit(APawn* HitPawn, EHitboxRegion::Type Region, const FVector& HitLocation, const FVector& SwingDirection);
+
+	//Interfaces
+
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "Item Action")
+		bool UseItem();
+		virtual bool UseItem_Implementation() override;
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "Item Pick Up")
+		bool PickUpItem();
+		virtual bool PickUpItem_Implementation() override;
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "Item Throw")
+		bool ThrowItem();
+		virtual bool ThrowItem_Implementation() override;
 
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "Actor Pool")
+		void OnAcquiredFromPool();
+		virtual void OnAcquiredFromPool_Implementation() override;
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "Actor Pool")
+		void OnReturnedToPool();
+		virtual void OnReturnedToPool_Implementation() override;
 	
 	
 };
@@ -0,0 +1,290 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#include "WesternWar.h"
+#include "Projectile.h"
+#include "UnrealNetwork.h"
+#include "Networking/NetTrafficStats.h"
+#include "GameManager/ActorPool.h"
+#include "GameManager/MainGameState.h"
+#include "Player/Character/PlayerCharacter.h"
+#include "Weapons/ProjectileWeapon.h"
+
+#define PREDICTED_PROJECTILE_TIMEOUT 1.0f	//Seconds past the flight time a predicted copy waits for the server
+
+AProjectile::AProjectile()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	ProjectileMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Projectile Mesh"));
+	ProjectileMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	RootComponent = ProjectileMesh;
+
+	//The path is simulated from the spawn data, nothing changes after the spawn
+	bReplicates = true;
+	bReplicateMovement = false;
+	NetUpdateFrequency = 1;
+}
+
+void AProjectile::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME_CONDITION(AProjectile, SpawnData, COND_InitialOnly);
+}
+
+void AProjectile::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (!bIsSimulating || bHasImpacted)
+	{
+		return;
+	}
+
+	const float FlightTime = GetFlightTime();
+
+	if (FlightTime > MaxFlightTime)
+	{
+		EndFlight();
+		return;
+	}
+
+	const FVector PreviousLocation = SimulatedLocation;
+	SimulatedLocation = GetLocationAtTime(FMath::Max(FlightTime, 0.0f));
+
+	//The segment flown this tick is traced like a hitscan shot, world geometry first & then the hitboxes of the characters
+	AProjectileWeapon* Weapon = Cast<AProjectileWeapon>(GetOwner());
+
+	FHitboxRay FlightRay;
+	FlightRay.Start = PreviousLocation;
+	FlightRay.End = SimulatedLocation;
+
+	FCollisionQueryParams TraceParams(FName(TEXT("Projectile Trace")), false, this);
+	TraceParams.AddIgnoredActor(Weapon);
+	TraceParams.AddIgnoredActor(Weapon ? Weapon->GetOwner() : nullptr);
+
+	FHitResult WorldHit(ForceInit);
+	const bool bIsWorldHit = GetWorld()->LineTraceSingleByObjectType(WorldHit, FlightRay.Start, FlightRay.End, FCollisionObjectQueryParams(ECC_WorldStatic), TraceParams);
+
+	if (bIsWorldHit)
+	{
+		FlightRay.End = WorldHit.ImpactPoint;
+	}
+
+	APlayerCharacter* HitCharacter = nullptr;
+	FHitboxRayResult HitResult;
+
+	if (Weapon && Weapon->TraceShownHitboxes(FlightRay, HitCharacter, HitResult))
+	{
+		Impact(FMath::Lerp(FlightRay.Start, FlightRay.End, HitResult.Time), HitCharacter, HitResult.Region);
+		return;
+	}
+
+	if (bIsWorldHit)
+	{
+		Impact(FlightRay.End, nullptr, EHitboxRegion::HR_None);
+		return;
+	}
+
+	FVector RenderLocation = SimulatedLocation;
+
+	if (!BlendOffset.IsZero())
+	{
+		const float BlendAlpha = PredictionBlendTime > 0 ? FMath::Clamp((GetWorld()->GetTimeSeconds() - BlendStartTime) / PredictionBlendTime, 0.0f, 1.0f) : 1;
+
+		RenderLocation += BlendOffset * (1 - BlendAlpha);
+
+		if (BlendAlpha >= 1)
+		{
+			BlendOffset = FVector::ZeroVector;
+		}
+	}
+
+	SetActorLocationAndRotation(RenderLocation, (SimulatedLocation - PreviousLocation).Rotation());
+}
+
+void AProjectile::InitAuthoritative(const FProjectileSpawnData& InSpawnData)
+{
+	SpawnData = InSpawnData;
+
+	UNetDriver* NetDriver = GetNetDriver();
+	FNetTrafficStats::Get().RecordRpcSent(ENetRpc::ReplicatedProjectileSpawnData, FNetTrafficStats::GetSerializedBits(SpawnData), NetDriver ? NetDriver->ClientConnections.Num() : 0);
+
+	StartSimulation();
+}
+
+void AProjectile::InitPredicted(const FProjectileSpawnData& InSpawnData)
+{
+	SpawnData = InSpawnData;
+	bIsPredicted = true;
+
+	StartSimulation();
+}
+
+//Clients - the spawn data arrives with the initial bunch only
+void AProjectile::OnRep_SpawnData()
+{
+	FNetTrafficStats::Get().RecordRpcReceived(ENetRpc::ReplicatedProjectileSpawnData, FNetTrafficStats::GetSerializedBits(SpawnData));
+
+	if (bIsSimulating || bHasImpacted)
+	{
+		return;
+	}
+
+	if (SpawnData.PredictionID != 0)
+	{
+		TakeOverPredictedProjectile();
+	}
+
+	if (!bHasImpacted)
+	{
+		StartSimulation();
+	}
+}
+
+//Predicted copies fly on the local clock, everything else on the server clock
+float AProjectile::GetFlightTime() const
+{
+	if (bIsPredicted)
+	{
+		return GetWorld()->GetTimeSeconds() - SpawnData.SpawnTime;
+	}
+
+	const AGameState* GameState = GetWorld()->GetGameState();
+	const float ServerTime = GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+
+	return ServerTime - SpawnData.SpawnTime + FlightTimeOffset;
+}
+
+FVector AProjectile::GetLocationAtTime(float FlightTime) const
+{
+	const FVector Gravity(0, 0, GetWorld()->GetGravityZ() * GravityScale);
+
+	return SpawnData.Origin + SpawnData.Velocity * FlightTime + 0.5f * Gravity * FlightTime * FlightTime;
+}
+
+void AProjectile::StartSimulation()
+{
+	bIsSimulating = true;
+	bHasImpacted = false;
+
+	SimulatedLocation = GetLocationAtTime(FMath::Max(GetFlightTime(), 0.0f));
+
+	SetActorLocationAndRotation(SimulatedLocation + BlendOffset, SpawnData.Velocity.Rotation());
+	SetActorTickEnabled(true);
+}
+
+/*
+* Owning client - replace the predicted copy of the shot instead of showing a second projectile
+* - The flight continues from the flight time of the copy, so the projectile does not jump back by the round trip time
+* - The remaining difference (quantized origin, server correction of the shot) is blended out
+* - A copy that has already hit something has shown the impact, the authoritative projectile stays hidden
+*/
+void AProjectile::TakeOverPredictedProjectile()
+{
+	AProjectileWeapon* Weapon = Cast<AProjectileWeapon>(GetOwner());
+	AProjectile* PredictedProjectile = Weapon ? Weapon->TakePredictedProjectile(SpawnData.PredictionID) : nullptr;
+
+	if (!PredictedProjectile)
+	{
+		return;
+	}
+
+	FlightTimeOffset = PredictedProjectile->GetFlightTime() - GetFlightTime();
+
+	if (PredictedProjectile->HasImpacted())
+	{
+		bHasImpacted = true;
+		SetActorHiddenInGame(true);
+		SetActorTickEnabled(false);
+	}
+	else
+	{
+		BlendOffset = PredictedProjectile->GetActorLocation() - GetLocationAtTime(FMath::Max(GetFlightTime(), 0.0f));
+		BlendStartTime = GetWorld()->GetTimeSeconds();
+	}
+
+	PredictedProjectile->ReturnToPool();
+}
+
+//Only the authoritative projectile on the server deals damage, every other copy only plays the effects
+void AProjectile::Impact(const FVector& ImpactLocation, APlayerCharacter* HitCharacter, EHitboxRegion::Type Region)
+{
+	bHasImpacted = true;
+
+	SetActorLocation(ImpactLocation);
+
+	if (!bIsPredicted && Role == ROLE_Authority && HitCharacter)
+	{
+		AProjectileWeapon* Weapon = Cast<AProjectileWeapon>(GetOwner());
+		APawn* OwnerPawn = Weapon ? Cast<APawn>(Weapon->GetOwner()) : nullptr;
+
+		FHitResult Hit(ForceInit);
+		Hit.Actor = HitCharacter;
+		Hit.Location = ImpactLocation;
+		Hit.ImpactPoint = ImpactLocation;
+
+		UGameplayStatics::ApplyPointDamage(HitCharacter, Weapon ? Weapon->GetDamageForRegion(Region) : 0, SpawnData.Velocity.GetSafeNormal(), Hit, OwnerPawn ? OwnerPawn->GetController() : nullptr, this, UDamageType::StaticClass());
+	}
+
+	if (GetNetMode() != NM_DedicatedServer)
+	{
+		OnProjectileImpact(ImpactLocation, HitCharacter);
+	}
+
+	EndFlight();
+}
+
+/*
+* Stop the flight
+* - Predicted copies stay hidden until the authoritative projectile takes over, so the impact is not shown twice
+* - The server keeps the projectile alive a little longer so clients behind it finish the flight themselves
+*/
+void AProjectile::EndFlight()
+{
+	bIsSimulating = false;
+
+	SetActorHiddenInGame(true);
+	SetActorTickEnabled(false);
+
+	if (!bIsPredicted && Role == ROLE_Authority)
+	{
+		SetLifeSpan(1);
+	}
+}
+
+void AProjectile::ReturnToPool()
+{
+	UActorPool* ActorPool = AMainGameState::GetWorldActorPool(this);
+
+	if (ActorPool)
+	{
+		ActorPool->ReleaseActor(this);
+	}
+	else
+	{
+		Destroy();
+	}
+}
+
+bool AProjectile::IsPredictionExpired() const
+{
+	return bIsPredicted && GetFlightTime() > MaxFlightTime + PREDICTED_PROJECTILE_TIMEOUT;
+}
+
+//INTERFACE FUNCTIONS
+
+void AProjectile::OnAcquiredFromPool_Implementation()
+{
+}
+
+//Reset the projectile so the next shot gets a fresh one
+void AProjectile::OnReturnedToPool_Implementation()
+{
+	SpawnData = FProjectileSpawnData();
+	bIsPredicted = false;
+	bIsSimulating = false;
+	bHasImpacted = false;
+	BlendOffset = FVector::ZeroVector;
+	FlightTimeOffset = 0;
+}
@@ -0,0 +1,105 @@
+// Copyright C++ Code by Klaudijus Miseckas for WesternWar project
+
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "Interfaces/PooledActorInterface.h"
+#include "Player/Character/PlayerHitboxes.h"
+#include "Projectile.generated.h"
+
+USTRUCT()
+struct FProjectileSpawnData
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY()
+		FVector_NetQuantize10 Origin;
+	UPROPERTY()
+		FVector_NetQuantize10 Velocity;
+	UPROPERTY()
+		float SpawnTime = 0;	//Server world time of the shot, predicted projectiles use the local world time
+	UPROPERTY()
+		int16 PredictionID = 0;	//Fire ID of the owning clients predicted projectile, 0 if there is none
+};
+
+/*
+* Projectile - travels a closed form ballistic path from its spawn data
+* - Only the spawn data is replicated (once), every machine simulates the same path from it
+* - The owning client flies a predicted copy from the actor pool as soon as it fires, the authoritative projectile
+*   takes over from it when it arrives & blends the difference out, the copy goes straight back to the pool
+* - Only the server applies damage
+*/
+UCLASS()
+class WESTERNWAR_API AProjectile : public AActor, public IPooledActorInterface
+{
+	GENERATED_BODY()
+
+private:
+	UPROPERTY(ReplicatedUsing = OnRep_SpawnData)
+		FProjectileSpawnData SpawnData;
+
+	UFUNCTION()
+		void OnRep_SpawnData();
+
+	bool bIsPredicted = false;
+	bool bIsSimulating = false;
+	bool bHasImpacted = false;
+
+	FVector SimulatedLocation = FVector::ZeroVector;
+
+	//Owning client - offset to the predicted copy at take over, blended to zero over PredictionBlendTime
+	FVector BlendOffset = FVector::ZeroVector;
+	float BlendStartTime = 0;
+	float FlightTimeOffset = 0;	//Owning client - keeps the authoritative projectile on the timeline of the prediction
+
+	float GetFlightTime() const;
+	FVector GetLocationAtTime(float FlightTime) const;
+
+	void StartSimulation();
+	void TakeOverPredictedProjectile();
+	void Impact(const FVector& ImpactLocation, class APlayerCharacter* HitCharacter, EHitboxRegion::Type Region);
+	void EndFlight();
+
+public:
+	AProjectile();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	//Server - the authoritative projectile, spawned with the weapon as owner
+	void InitAuthoritative(const FProjectileSpawnData& InSpawnData);
+
+	//Owning client - the predicted copy, acquired from the actor pool with the weapon as owner
+	void InitPredicted(const FProjectileSpawnData& InSpawnData);
+
+	//Predicted copies go back to the actor pool, the server did not fire the shot or it has been taken over
+	void ReturnToPool();
+
+	//Owning client - the server has not answered for the predicted copy, the shot or its answer was lost
+	bool IsPredictionExpired() const;
+
+	int16 GetPredictionID() const { return SpawnData.PredictionID; }
+	bool HasImpacted() const { return bHasImpacted; }
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Projectile")
+		UStaticMeshComponent* ProjectileMesh;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Projectile")
+		float GravityScale = 1;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Projectile")
+		float MaxFlightTime = 5;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Projectile")
+		float PredictionBlendTime = 0.15f;
+
+	//Impact effects, not called on dedicated servers
+	UFUNCTION(BlueprintImplementableEvent, Category = "Projectile")
+		void OnProjectileImpact(FVector ImpactLocation, APawn* HitPawn);
+
+	//Interfaces
+
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "Actor Pool")
+		void OnAcquiredFromPool();
+		virtual void OnAcquiredFromPool_Implementation() override;
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "Actor Pool")
+		void OnReturnedToPool();
+		virtual void OnReturnedToPool_Implementation() override;
+};
@@ -2,7 +2,49 @@
 
 #include "WesternWar.h"
 #include "ProjectileWeapon.h"
+#include "UnrealNetwork.h"
+#include "Networking/NetTrafficStats.h"
+#include "GameManager/MainGameState.h"
+#include "Player/Character/PlayerCharacter.h"
+#include "Player/MainPlayerState.h"
+#include "Weapons/Projectile.h"
+
+bool FReplicatedWeaponState::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	uint8 Flags = (bIsReloading ? 1 : 0) | (bIsADS ? 2 : 0) | ((uint8)WeaponState.GetValue() << 2);
+
+	Ar.SerializeBits(&ClipAmmo, 8);
+	Ar.SerializeBits(&Flags, 4);
+	Ar << SimulationID;
+	Ar.SerializeBits(&ReloadSequence, 4);
+
+	if (Ar.IsLoading())
+	{
+		bIsReloading = (Flags & 1) != 0;
+		bIsADS = (Flags & 2) != 0;
+		WeaponState = (EWeaponState::Type)((Flags >> 2) & 3);
+	}
+
+	bOutSuccess = true;
+	return true;
+}
+
+bool FHitConfirmation::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	uint8 Flags = (bIsConfirmed ? 1 : 0) | ((uint8)Region.GetValue() << 1);
 
+	Ar << SimulationID;
+	Ar.SerializeBits(&Flags, 4);
+
+	if (Ar.IsLoading())
+	{
+		bIsConfirmed = (Flags & 1) != 0;
+		Region = (EHitboxRegion::Type)((Flags >> 1) & 7);
+	}
+
+	bOutSuccess = true;
+	return true;
+}
 
 // Sets default values
 AProjectileWeapon::AProjectileWeapon()
@@ -12,6 +54,15 @@ AProjectileWeapon::AProjectileWeapon()
 
 	WeaponMesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("Weapon Skeletal Mesh"));
 
+	bReplicates = true;
+
+}
+
+void AProjectileWeapon::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AProjectileWeapon, ReplicatedWeaponState);
 }
 
 // Called when the game starts or when spawned
@@ -21,36 +72,164 @@ void AProjectileWeapon::BeginPlay()
 	
 }
 
+//Remove the reload timer if the weapon is destroyed mid reload
+void AProjectileWeapon::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GetWorldTimerManager().ClearTimer(ReloadTimerHandle);
+	ReleasePredictedProjectiles(false);
+
+	Super::EndPlay(EndPlayReason);
+}
+
 // Called every frame
 void AProjectileWeapon::Tick( float DeltaTime )
 {
 	Super::Tick( DeltaTime );
 
+	if (PendingHitConfirmations.Num() > 0)
+	{
+		SendHitConfirmations();
+	}
+
+	if (PendingRejectedProjectiles.Num() > 0)
+	{
+		SendProjectileRejections();
+	}
+
+	if (PredictedProjectiles.Num() > 0)
+	{
+		ReleasePredictedProjectiles(true);
+	}
+
 }
 
+/*
+* Fire the weapon - client side prediction
+* The ammo is taken straight away & the fire ID is kept until the server
+* acknowledges it through the replicated weapon state
+*/
 void AProjectileWeapon::Fire()
 {
+	if (!CanFire())
+	{
+		return;
+	}
 
+	//The server advances its fire ID when it processes the fire
+	const int16 NewFireSimulationID = FireSimulationID + 1;
+
+	if (Role < ROLE_Authority)
+	{
+		FireSimulationID = NewFireSimulationID;
+	}
+
+	ClientFireData.ProjectileStart = GetActorLocation();
+	ClientFireData.ProjectileDirection = GetActorForwardVector();
+	ClientFireData.SimulationID = NewFireSimulationID;
+	ClientFireData.bIsPlayerHit = false;
+	ClientFireData.HitPlayerSimulationID = 0;
+	ClientFireData.PlayerNetworkID = 0;
+	ClientFireData.bHasPredictedProjectile = false;
+
+	//Hit effects are shown straight away, the server only has to verify the claimed hit
+	APlayerCharacter* HitCharacter = nullptr;
+	FHitboxRayResult HitResult;
+	const FHitboxRay ShotRay = *ProjectileClass ? FHitboxRay() : GetShotRay(ClientFireData.ProjectileStart, ClientFireData.ProjectileDirection);
+
+	if (!*ProjectileClass && TraceShownHitboxes(ShotRay, HitCharacter, HitResult))
+	{
+		ClientFireData.bIsPlayerHit = true;
+		ClientFireData.HitPlayerSimulationID = HitCharacter->GetDisplayedSimulationID();
+		ClientFireData.PlayerNetworkID = HitCharacter->PlayerState->PlayerId;
+
+		if (PredictedHits.Num() >= MAX_PREDICTED_HITS)
+		{
+			PredictedHits.RemoveAt(0, 1, false);
+		}
+
+		FPredictedHit PredictedHit;
+		PredictedHit.SimulationID = NewFireSimulationID;
+		PredictedHit.HitPawn = HitCharacter;
+		PredictedHit.Region = HitResult.Region;
+		PredictedHits.Add(PredictedHit);
+
+		OnPredictedHit(HitCharacter, FMath::Lerp(ShotRay.Start, ShotRay.End, HitResult.Time), HitResult.Region);
+	}
+
+	//The server takes the ammo itself when it runs Server_SendGunFire
+	if (Role < ROLE_Authority)
+	{
+		ClipAmmo--;
+		PendingFireSimulationIDs.Add(FireSimulationID);
+
+		if (*ProjectileClass)
+		{
+			ClientFireData.bHasPredictedProjectile = SpawnPredictedProjectile();
+		}
+	}
+
+	Server_SendGunFire(ClientFireData);
+	FNetTrafficStats::Get().RecordRpcSent(ENetRpc::Server_SendGunFire, FNetTrafficStats::GetSerializedBits(ClientFireData));
 }
 
 void AProjectileWeapon::Reload()
 {
+	if (bIsReloading || ClipAmmo >= MaxClipAmmo)
+	{
+		return;
+	}
+
+	//Predicted until the server answers this request, the server runs the reload itself
+	if (Role < ROLE_Authority)
+	{
+		bIsReloading = true;
+		bIsReloadPending = true;
+	}
 
+	ReloadSequence = (ReloadSequence + 1) & RELOAD_SEQUENCE_MASK;
+
+	Server_SendReload(ReloadSequence);
+	FNetTrafficStats::Get().RecordRpcSent(ENetRpc::Server_SendReload, 8);
 }
 
 void AProjectileWeapon::AimDownSightsToggle()
 {
+	bIsADS = !bIsADS;
 
+	Server_SendAimDownSights(bIsADS);
+	FNetTrafficStats::Get().RecordRpcSent(ENetRpc::Server_SendAimDownSights, 1);
 }
 
 void AProjectileWeapon::AimDownSightsHold()
 {
+	if (!bIsADS)
+	{
+		bIsADS = true;
 
+		Server_SendAimDownSights(bIsADS);
+		FNetTrafficStats::Get().RecordRpcSent(ENetRpc::Server_SendAimDownSights, 1);
+	}
+}
+
+//Server only - refill the clip once the reload time has passed
+void AProjectileWeapon::FinishReload()
+{
+	bIsReloading = false;
+	ClipAmmo = MaxClipAmmo;
+
+	UpdateReplicatedWeaponState();
+}
+
+bool AProjectileWeapon::IsLocallyOwned() const
+{
+	APawn* OwnerPawn = Cast<APawn>(GetOwner());
+
+	return OwnerPawn && OwnerPawn->IsLocallyControlled();
 }
 
 bool AProjectileWeapon::IsClipEmpty()
 {
-	return false;
+	return ClipAmmo <= 0;
 }
 
 bool AProjectileWeapon::IsCarryingAmmo()
@@ -60,7 +239,267 @@ bool AProjectileWeapon::IsCarryingAmmo()
 
 bool AProjectileWeapon::CanFire()
 {
-	return false;
+	return bCanShoot && !bIsReloading && !IsClipEmpty() && WeaponState == EWeaponState::WP_None;
+}
+
+//The shot is stopped by the first static world geometry, pawns are only hit through their hitboxes
+FHitboxRay AProjectileWeapon::GetShotRay(const FVector& Start, const FVector& Direction) const
+{
+	FHitboxRay ShotRay;
+	ShotRay.Start = Start;
+	ShotRay.End = Start + Direction.GetSafeNormal() * Range;
+
+	FCollisionQueryParams TraceParams(FName(TEXT("Shot Trace")), false, this);
+	TraceParams.AddIgnoredActor(GetOwner());
+
+	FHitResult WorldHit(ForceInit);
+
+	if (GetWorld()->LineTraceSingleByObjectType(WorldHit, ShotRay.Start, ShotRay.End, FCollisionObjectQueryParams(ECC_WorldStatic), TraceParams))
+	{
+		ShotRay.End = WorldHit.ImpactPoint;
+	}
+
+	return ShotRay;
+}
+
+/*
+* Trace a ray against the hitboxes of the characters where they are shown (interpolated on clients)
+* - Characters far from the ray are culled before their hitboxes are built
+*/
+bool AProjectileWeapon::TraceShownHitboxes(const FHitboxRay& ShotRay, APlayerCharacter*& OutHitCharacter, FHitboxRayResult& OutResult)
+{
+	HitboxCharacters.Reset();
+
+	for (TActorIterator<APlayerCharacter> It(GetWorld()); It; ++It)
+	{
+		APlayerCharacter* PlayerCharacter = *It;
+
+		if (PlayerCharacter != GetOwner() && PlayerCharacter->PlayerState && FMath::PointDistToSegmentSquared(PlayerCharacter->GetActorLocation(), ShotRay.Start, ShotRay.End) <= FMath::Square(300))
+		{
+			HitboxCharacters.Add(PlayerCharacter);
+		}
+	}
+
+	if (HitboxCharacters.Num() == 0)
+	{
+		return false;
+	}
+
+	HitboxSets.SetNum(HitboxCharacters.Num(), false);
+	HitboxSetPtrs.Reset();
+
+	for (int32 i = 0; i < HitboxCharacters.Num(); i++)
+	{
+		HitboxCharacters[i]->GetDisplayedHitboxes(HitboxSets[i]);
+		HitboxSetPtrs.Add(&HitboxSets[i]);
+	}
+
+	HitboxKernel::RaycastHitboxes(&ShotRay, 1, HitboxSetPtrs.GetData(), HitboxSetPtrs.Num(), &OutResult);
+
+	if (OutResult.HitboxSetIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	OutHitCharacter = HitboxCharacters[OutResult.HitboxSetIndex];
+
+	return true;
+}
+
+/*
+* Server - verify a hit the client claims instead of searching for one
+* - The hit player is rewound to the tick at which the server had simulated the move the client was showing
+* - Only the hitboxes of the claimed player are tested, with a single ray
+*/
+bool AProjectileWeapon::VerifyHit(const FGunFireData& FireData, const FHitboxRay& ShotRay, APlayerCharacter*& OutHitCharacter, FHitboxRayResult& OutResult) const
+{
+	const APawn* OwnerPawn = Cast<APawn>(GetOwner());
+	const FWorldSnapshotHistory* SnapshotHistory = AMainGameState::GetWorldSnapshotHistory(this);
+
+	if (!OwnerPawn || !SnapshotHistory)
+	{
+		return false;
+	}
+
+	if (FVector::DistSquared(FireData.ProjectileStart, OwnerPawn->GetActorLocation()) > FMath::Square(MaxFireOriginError))
+	{
+		return false;
+	}
+
+	APlayerCharacter* HitCharacter = nullptr;
+
+	for (int32 Slot = 0; Slot < WORLD_SNAPSHOT_MAX_PAWNS && !HitCharacter; Slot++)
+	{
+		APawn* Pawn = SnapshotHistory->GetPawn(Slot);
+
+		if (Pawn && Pawn != OwnerPawn && Pawn->PlayerState && Pawn->PlayerState->PlayerId == FireData.PlayerNetworkID)
+		{
+			HitCharacter = Cast<APlayerCharacter>(Pawn);
+		}
+	}
+
+	if (!HitCharacter)
+	{
+		return false;
+	}
+
+	const int32 HistoryTick = SnapshotHistory->FindTickForSimulationID(HitCharacter->GetWorldSnapshotSlot(), FireData.HitPlayerSimulationID);
+
+	if (HistoryTick == INDEX_NONE)
+	{
+		return false;
+	}
+
+	//Shots the shooter saw further in the past than its lag compensation window are not rewound
+	const AMainPlayerState* MainPlayerState = Cast<AMainPlayerState>(OwnerPawn->PlayerState);
+
+	if (MainPlayerState && !MainPlayerState->IsWithinLagCompensationWindow(GetWorld()->GetTimeSeconds() - SnapshotHistory->GetTickTime(HistoryTick)))
+	{
+		return false;
+	}
+
+	if (!HitCharacter->CheckForProjectileImpact(ShotRay, HistoryTick, OutResult))
+	{
+		return false;
+	}
+
+	OutHitCharacter = HitCharacter;
+
+	return true;
+}
+
+//Server - every verdict of the tick in one RPC
+void AProjectileWeapon::SendHitConfirmations()
+{
+	Client_ConfirmHits(PendingHitConfirmations);
+	FNetTrafficStats::Get().RecordRpcSent(ENetRpc::Client_ConfirmHits, FNetTrafficStats::GetSerializedBits(PendingHitConfirmations));
+
+	PendingHitConfirmations.Reset();
+}
+
+//Owning client - fly the shot straight away, the authoritative projectile takes over once the server has fired it
+bool AProjectileWeapon::SpawnPredictedProjectile()
+{
+	UActorPool* ActorPool = AMainGameState::GetWorldActorPool(this);
+
+	//Fire ID 0 means no prediction, skipped when the fire IDs wrap around
+	if (!ActorPool || FireSimulationID == 0)
+	{
+		return false;
+	}
+
+	AProjectile* Projectile = ActorPool->AcquireActor<AProjectile>(ProjectileClass, FTransform(ClientFireData.ProjectileDirection.Rotation(), ClientFireData.ProjectileStart), this);
+
+	if (!Projectile)
+	{
+		return false;
+	}
+
+	FProjectileSpawnData SpawnData;
+	SpawnData.Origin = ClientFireData.ProjectileStart;
+	SpawnData.Velocity = ClientFireData.ProjectileDirection.GetSafeNormal() * ProjectileSpeed;
+	SpawnData.SpawnTime = GetWorld()->GetTimeSeconds();
+	SpawnData.PredictionID = FireSimulationID;
+
+	Projectile->InitPredicted(SpawnData);
+	PredictedProjectiles.Add(Projectile);
+
+	return true;
+}
+
+//Server - the projectile every machine simulates, carries the fire ID of the clients predicted copy
+bool AProjectileWeapon::SpawnAuthoritativeProjectile(const FGunFireData& FireData)
+{
+	APawn* OwnerPawn = Cast<APawn>(GetOwner());
+
+	if (!OwnerPawn || FVector::DistSquared(FireData.ProjectileStart, OwnerPawn->GetActorLocation()) > FMath::Square(MaxFireOriginError))
+	{
+		return false;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Owner = this;
+	SpawnParams.Instigator = OwnerPawn;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	AProjectile* Projectile = GetWorld()->SpawnActor<AProjectile>(ProjectileClass, FireData.ProjectileStart, FireData.ProjectileDirection.Rotation(), SpawnParams);
+
+	if (!Projectile)
+	{
+		return false;
+	}
+
+	FProjectileSpawnData SpawnData;
+	SpawnData.Origin = FireData.ProjectileStart;
+	SpawnData.Velocity = FireData.ProjectileDirection.GetSafeNormal() * ProjectileSpeed;
+	SpawnData.SpawnTime = GetWorld()->GetTimeSeconds();
+	SpawnData.PredictionID = FireData.bHasPredictedProjectile ? FireData.SimulationID : 0;
+
+	Projectile->InitAuthoritative(SpawnData);
+
+	return true;
+}
+
+//Server - every rejected prediction of the tick in one RPC
+void AProjectileWeapon::SendProjectileRejections()
+{
+	Client_RejectProjectiles(PendingRejectedProjectiles);
+	FNetTrafficStats::Get().RecordRpcSent(ENetRpc::Client_RejectProjectiles, NET_ARRAY_NUM_BITS + PendingRejectedProjectiles.Num() * 16);
+
+	PendingRejectedProjectiles.Reset();
+}
+
+AProjectile* AProjectileWeapon::TakePredictedProjectile(int16 PredictionID)
+{
+	for (int32 i = 0; i < PredictedProjectiles.Num(); i++)
+	{
+		AProjectile* Projectile = PredictedProjectiles[i].Get();
+
+		if (Projectile && Projectile->GetPredictionID() == PredictionID)
+		{
+			PredictedProjectiles.RemoveAtSwap(i, 1, false);
+
+			return Projectile;
+		}
+	}
+
+	return nullptr;
+}
+
+//Owning client - return predicted copies the server never answered for (or all of them) to the actor pool
+void AProjectileWeapon::ReleasePredictedProjectiles(bool bOnlyExpired)
+{
+	for (int32 i = PredictedProjectiles.Num() - 1; i >= 0; i--)
+	{
+		AProjectile* Projectile = PredictedProjectiles[i].Get();
+
+		if (!Projectile || !bOnlyExpired || Projectile->IsPredictionExpired())
+		{
+			PredictedProjectiles.RemoveAtSwap(i, 1, false);
+
+			if (Projectile)
+			{
+				Projectile->ReturnToPool();
+			}
+		}
+	}
+}
+
+float AProjectileWeapon::GetDamageForRegion(EHitboxRegion::Type Region) const
+{
+	switch (Region)
+	{
+	case EHitboxRegion::HR_Head:
+		return HeadShotDamage;
+	case EHitboxRegion::HR_Body:
+		return BodyShotDamage;
+	case EHitboxRegion::HR_Arm:
+		return ArmShotDamage;
+	case EHitboxRegion::HR_Leg:
+		return LegShotDamage;
+	default:
+		return 0;
+	}
 }
 
 //INTERFACE FUNCTIONS
@@ -80,22 +519,249 @@ bool AProjectileWeapon::ThrowItem_Implementation()
 	return true;
 }
 
+void AProjectileWeapon::OnAcquiredFromPool_Implementation()
+{
+	ClipAmmo = MaxClipAmmo;
+
+	if (Role == ROLE_Authority)
+	{
+		UpdateReplicatedWeaponState();
+	}
+}
+
+//Reset the weapon so the next user of the pooled actor gets a fresh weapon
+void AProjectileWeapon::OnReturnedToPool_Implementation()
+{
+	ClipAmmo = 0;
+	bIsADS = false;
+	bCanShoot = true;
+	WeaponState = EWeaponState::WP_None;
+	bIsReloading = false;
+	bIsReloadPending = false;
+	ReloadSequence = 0;
+	FireSimulationID = 0;
+	PendingFireSimulationIDs.Empty();
+	PredictedHits.Empty();
+	PendingHitConfirmations.Empty();
+	ReleasePredictedProjectiles(false);
+	PendingRejectedProjectiles.Empty();
+
+	if (Role == ROLE_Authority)
+	{
+		GetWorldTimerManager().ClearTimer(ReloadTimerHandle);
+		UpdateReplicatedWeaponState();
+	}
+}
+
 
 //NETWORKING FUNCTIONS
 
-bool AProjectileWeapon::Server_SendGunFire_Validate(FGunFireData ClientFireData)
+//Server only - copy the weapon state into the replicated struct, it is only sent to clients if a value changed
+void AProjectileWeapon::UpdateReplicatedWeaponState()
 {
-	if (ClipAmmo <= 0)
+	const FReplicatedWeaponState PreviousWeaponState = ReplicatedWeaponState;
+
+	ReplicatedWeaponState.ClipAmmo = (uint8)FMath::Clamp(ClipAmmo, 0, 255);
+	ReplicatedWeaponState.bIsReloading = bIsReloading;
+	ReplicatedWeaponState.bIsADS = bIsADS;
+	ReplicatedWeaponState.WeaponState = WeaponState;
+	ReplicatedWeaponState.SimulationID = FireSimulationID;
+	ReplicatedWeaponState.ReloadSequence = ReloadSequence;
+
+	if (!FReplicatedWeaponState::StaticStruct()->CompareScriptStruct(&PreviousWeaponState, &ReplicatedWeaponState, 0))
 	{
-		return false;
+		bIsWeaponStateDirty = true;
 	}
+}
+
+//Count the replicated weapon state once per replication it changed in, however often it changed in between
+void AProjectileWeapon::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+
+	if (bIsWeaponStateDirty)
+	{
+		bIsWeaponStateDirty = false;
+
+		UNetDriver* NetDriver = GetNetDriver();
+		FNetTrafficStats::Get().RecordRpcSent(ENetRpc::ReplicatedWeaponState, FNetTrafficStats::GetSerializedBits(ReplicatedWeaponState), NetDriver ? NetDriver->ClientConnections.Num() : 0);
+	}
+}
+
+/*
+* Reconcile the client with the server weapon state
+* - Owning client keeps its own ADS, keeps a predicted reload until the server has answered it
+*   & re-applies the shots the server has not processed yet
+* - Other clients take the server state as it is
+*/
+void AProjectileWeapon::OnRep_WeaponState()
+{
+	FNetTrafficStats::Get().RecordRpcReceived(ENetRpc::ReplicatedWeaponState, FNetTrafficStats::GetSerializedBits(ReplicatedWeaponState));
+
+	WeaponState = ReplicatedWeaponState.WeaponState;
+
+	if (IsLocallyOwned())
+	{
+		if (bIsReloadPending && ReplicatedWeaponState.ReloadSequence == ReloadSequence)
+		{
+			bIsReloadPending = false;
+		}
+
+		if (!bIsReloadPending)
+		{
+			bIsReloading = ReplicatedWeaponState.bIsReloading;
+		}
 
+		const int16 AckedSimulationID = ReplicatedWeaponState.SimulationID;
+
+		//Remove every fire ID that is the same as or older than the acknowledged ID (IDs wrap around)
+		PendingFireSimulationIDs.RemoveAll([AckedSimulationID](int16 PendingID)
+		{
+			return (int16)(PendingID - AckedSimulationID) <= 0;
+		});
+
+		ClipAmmo = FMath::Max(ReplicatedWeaponState.ClipAmmo - PendingFireSimulationIDs.Num(), 0);
+	}
+	else
+	{
+		bIsReloading = ReplicatedWeaponState.bIsReloading;
+		ClipAmmo = ReplicatedWeaponState.ClipAmmo;
+		bIsADS = ReplicatedWeaponState.bIsADS;
+	}
+}
+
+/*
+* Fire requests the server can't carry out are not kicked, they are ignored
+* and the client corrects its predicted ammo once the replicated state arrives
+*/
+bool AProjectileWeapon::Server_SendGunFire_Validate(FGunFireData ClientFireData)
+{
 	return true;
 }
 
 void AProjectileWeapon::Server_SendGunFire_Implementation(FGunFireData ClientFireData)
 {
+	FNetTrafficStats::Get().RecordRpcReceived(ENetRpc::Server_SendGunFire, FNetTrafficStats::GetSerializedBits(ClientFireData));
+
+	//Fires are unreliable & can arrive out of order, a fire older than the last processed one is dropped
+	//so the acknowledged fire ID never moves back, its predicted hit & projectile are rejected
+	if ((int16)(ClientFireData.SimulationID - FireSimulationID) <= 0)
+	{
+		if (ClientFireData.bIsPlayerHit)
+		{
+			FHitConfirmation Rejection;
+			Rejection.SimulationID = ClientFireData.SimulationID;
+			PendingHitConfirmations.Add(Rejection);
+		}
+
+		if (ClientFireData.bHasPredictedProjectile)
+		{
+			PendingRejectedProjectiles.Add(ClientFireData.SimulationID);
+		}
+
+		return;
+	}
+
+	FireSimulationID = ClientFireData.SimulationID;
+
+	FHitConfirmation HitConfirmation;
+	HitConfirmation.SimulationID = ClientFireData.SimulationID;
+
+	bool bIsProjectileFired = false;
+
+	if (CanFire())
+	{
+		ClipAmmo--;
+		MultiCastClient_ReplicateGunFireToClients();
+
+		const APlayerCharacter* OwnerCharacter = Cast<APlayerCharacter>(GetOwner());
+		AMainGameState* MainGameState = Cast<AMainGameState>(GetWorld()->GetGameState());
+
+		if (OwnerCharacter && MainGameState)
+		{
+			MainGameState->GetKillcamHistory().RecordFireEvent(OwnerCharacter->GetWorldSnapshotSlot(), ClientFireData.ProjectileStart, ClientFireData.ProjectileDirection);
+		}
+
+		APlayerCharacter* HitCharacter = nullptr;
+		FHitboxRayResult HitResult;
+
+		if (*ProjectileClass)
+		{
+			bIsProjectileFired = SpawnAuthoritativeProjectile(ClientFireData);
+		}
+		else if (ClientFireData.bIsPlayerHit)
+		{
+			const FHitboxRay ShotRay = GetShotRay(ClientFireData.ProjectileStart, ClientFireData.ProjectileDirection);
+
+			if (VerifyHit(ClientFireData, ShotRay, HitCharacter, HitResult))
+			{
+				HitConfirmation.bIsConfirmed = true;
+				HitConfirmation.Region = HitResult.Region;
+
+				FHitResult Hit(ForceInit);
+				Hit.Actor = HitCharacter;
+				Hit.Location = FMath::Lerp(ShotRay.Start, ShotRay.End, HitResult.Time);
+				Hit.ImpactPoint = Hit.Location;
+
+				UGameplayStatics::ApplyPointDamage(HitCharacter, GetDamageForRegion(HitResult.Region), ClientFireData.ProjectileDirection, Hit, OwnerCharacter ? OwnerCharacter->GetController() : nullptr, this, UDamageType::StaticClass());
+			}
+		}
+
+		UNetDriver* NetDriver = GetNetDriver();
+		FNetTrafficStats::Get().RecordRpcSent(ENetRpc::MultiCastClient_ReplicateGunFireToClients, 0, NetDriver ? NetDriver->ClientConnections.Num() : 0);
+	}
+
+	//Shots the server could not carry out reject their predicted hit as well
+	if (ClientFireData.bIsPlayerHit)
+	{
+		PendingHitConfirmations.Add(HitConfirmation);
+	}
+
+	//The predicted projectile of a shot the server did not fire is torn down on the client
+	if (ClientFireData.bHasPredictedProjectile && !bIsProjectileFired)
+	{
+		PendingRejectedProjectiles.Add(ClientFireData.SimulationID);
+	}
+
+	UpdateReplicatedWeaponState();
+}
+
+bool AProjectileWeapon::Server_SendReload_Validate(uint8 ClientReloadSequence)
+{
+	return true;
+}
+
+//The request is answered through the replicated reload sequence, whether the reload is started or not
+void AProjectileWeapon::Server_SendReload_Implementation(uint8 ClientReloadSequence)
+{
+	FNetTrafficStats::Get().RecordRpcReceived(ENetRpc::Server_SendReload, 8);
+
+	ReloadSequence = ClientReloadSequence & RELOAD_SEQUENCE_MASK;
 
+	if (bIsReloading || ClipAmmo >= MaxClipAmmo)
+	{
+		UpdateReplicatedWeaponState();
+		return;
+	}
+
+	bIsReloading = true;
+	GetWorldTimerManager().SetTimer(ReloadTimerHandle, this, &AProjectileWeapon::FinishReload, ReloadTime, false);
+
+	UpdateReplicatedWeaponState();
+}
+
+bool AProjectileWeapon::Server_SendAimDownSights_Validate(bool bNewIsADS)
+{
+	return true;
+}
+
+void AProjectileWeapon::Server_SendAimDownSights_Implementation(bool bNewIsADS)
+{
+	FNetTrafficStats::Get().RecordRpcReceived(ENetRpc::Server_SendAimDownSights, 1);
+
+	bIsADS = bNewIsADS;
+
+	UpdateReplicatedWeaponState();
 }
 
 bool AProjectileWeapon::MultiCastClient_ReplicateGunFireToClients_Validate()
@@ -105,15 +771,55 @@ bool AProjectileWeapon::MultiCastClient_ReplicateGunFireToClients_Validate()
 
 void AProjectileWeapon::MultiCastClient_ReplicateGunFireToClients_Implementation()
 {
+	if (Role < ROLE_Authority)
+	{
+		FNetTrafficStats::Get().RecordRpcReceived(ENetRpc::MultiCastClient_ReplicateGunFireToClients, 0);
+	}
 
 }
 
-bool AProjectileWeapon::Client_CheckPlayerGunStats_Validate(FServerGunData ServerGunData)
+void AProjectileWeapon::Client_ConfirmHits_Implementation(const TArray<FHitConfirmation>& Confirmations)
 {
-	return true;
+	FNetTrafficStats::Get().RecordRpcReceived(ENetRpc::Client_ConfirmHits, FNetTrafficStats::GetSerializedBits(Confirmations));
+
+	for (const FHitConfirmation& Confirmation : Confirmations)
+	{
+		const int32 PredictedHitIndex = PredictedHits.IndexOfByPredicate([&Confirmation](const FPredictedHit& PredictedHit)
+		{
+			return PredictedHit.SimulationID == Confirmation.SimulationID;
+		});
+
+		if (PredictedHitIndex == INDEX_NONE)
+		{
+			continue;
+		}
+
+		APawn* HitPawn = PredictedHits[PredictedHitIndex].HitPawn.Get();
+
+		if (Confirmation.bIsConfirmed)
+		{
+			OnHitConfirmed(HitPawn, Confirmation.Region);
+		}
+		else
+		{
+			OnHitRejected(HitPawn);
+		}
+
+		PredictedHits.RemoveAt(PredictedHitIndex, 1, false);
+	}
 }
 
-void AProjectileWeapon::Client_CheckPlayerGunStats_Implementation(FServerGunData ServerGunData)
+void AProjectileWeapon::Client_RejectProjectiles_Implementation(const TArray<int16>& PredictionIDs)
 {
+	FNetTrafficStats::Get().RecordRpcReceived(ENetRpc::Client_RejectProjectiles, NET_ARRAY_NUM_BITS + PredictionIDs.Num() * 16);
 
-}
\ No newline at end of file
+	for (int16 PredictionID : PredictionIDs)
+	{
+		AProjectile* Projectile = TakePredictedProjectile(PredictionID);
+
+		if (Projectile)
+		{
+			Projectile->ReturnToPool();
+		}
+	}
+}
@@ -4,8 +4,13 @@
 
 #include "GameFramework/Actor.h"
 #include "Interfaces/ItemInterface.h"
+#include "Interfaces/PooledActorInterface.h"
+#include "Player/Character/PlayerHitboxes.h"
 #include "ProjectileWeapon.generated.h"
 
+#define MAX_PREDICTED_HITS 16	//Unconfirmed client hits kept, the oldest is dropped when a new one does not fit
+#define RELOAD_SEQUENCE_MASK 15	//Reload requests are numbered with 4 bits, only one can be in flight at a time
+
 USTRUCT()
 struct FGunFireData
 {
@@ -16,44 +21,108 @@ struct FGunFireData
 	UPROPERTY()
 		FVector ProjectileDirection;
 	UPROPERTY()
-		bool bIsPlayerHit = false;
+		bool bIsPlayerHit = false;	//Client predicted a hit, the server verifies it instead of searching for one
+	UPROPERTY()
+		int16 HitPlayerSimulationID = 0;	//Server move of the hit player the shooting client was showing
 	UPROPERTY()
-		int16 HitPlayerSimulationID = 0;
+		int32 PlayerNetworkID = 0;	//PlayerId of the hit player
 	UPROPERTY()
-		int32 PlayerNetworkID = 0;
+		bool bHasPredictedProjectile = false;	//Client flies a predicted projectile under SimulationID, the server maps its projectile to it
 	UPROPERTY()
 		int16 SimulationID = 0;
 };
 
+UENUM(BlueprintType)
+namespace EWeaponState
+{
+	enum Type
+	{
+		WP_Busy,
+		WP_None,
+	};
+}
+
 USTRUCT()
-struct FServerGunData
+struct FReplicatedWeaponState
 {
+	/*
+	* Server weapon state, replicated as a property so it is only sent when one of the values changes
+	* - Bit packed to 32 bits by NetSerialize
+	* - SimulationID is the last client fire ID the server has processed, used to reconcile predicted ammo
+	* - ReloadSequence is the last client reload request the server has answered, rejected requests change it too
+	*   so the client always hears back about its predicted reload
+	*/
+
 	GENERATED_USTRUCT_BODY()
 
 	UPROPERTY()
-		int16 ClipAmmo = 0;
+		uint8 ClipAmmo = 0;
+	UPROPERTY()
+		bool bIsReloading = false;
+	UPROPERTY()
+		bool bIsADS = false;
+	UPROPERTY()
+		TEnumAsByte<EWeaponState::Type> WeaponState = EWeaponState::WP_None;
 	UPROPERTY()
 		int16 SimulationID = 0;
+	UPROPERTY()
+		uint8 ReloadSequence = 0;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
 };
 
-UENUM(BlueprintType)
-namespace EWeaponState
+template<>
+struct TStructOpsTypeTraits<FReplicatedWeaponState> : public TStructOpsTypeTraitsBase
 {
-	enum Type
+	enum
 	{
-		WP_Busy,
-		WP_None,
+		WithNetSerializer = true,
 	};
-}
+};
+
+USTRUCT()
+struct FHitConfirmation
+{
+	/*
+	* Server verdict on a hit the client predicted
+	* - Bit packed to 20 bits by NetSerialize, every verdict of a server tick is sent in one RPC
+	*/
+
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY()
+		int16 SimulationID = 0;
+	UPROPERTY()
+		bool bIsConfirmed = false;
+	UPROPERTY()
+		TEnumAsByte<EHitboxRegion::Type> Region = EHitboxRegion::HR_None;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FHitConfirmation> : public TStructOpsTypeTraitsBase
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+struct FPredictedHit
+{
+	int16 SimulationID;
+	TWeakObjectPtr<APawn> HitPawn;
+	EHitboxRegion::Type Region;
+};
 
 
 UCLASS()
-class AProjectileWeapon : public AActor, public IItemInterface
+class AProjectileWeapon : public AActor, public IItemInterface, public IPooledActorInterface
 {
 	GENERATED_BODY()
 	
 private:
-	void Fire();
 	void Reload();
 	void AimDownSightsToggle();
 	void AimDownSightsHold();
@@ -62,22 +131,72 @@ private:
 	bool IsCarryingAmmo();
 	bool CanFire();
 
+	bool IsLocallyOwned() const;
+	void FinishReload();
+
 	int ClipAmmo = 0;
 
 	bool bIsADS = false;
 	bool bCanShoot = true;
+	bool bIsReloading = false;
+
+	FTimerHandle ReloadTimerHandle;
 
 	//Network related variables
 
 	FGunFireData ClientFireData;
+	int16 FireSimulationID = 0;
+
+	uint8 ReloadSequence = 0;	//Last reload request sent (client) or answered (server)
+	bool bIsReloadPending = false;	//Client predicted a reload the server has not answered yet
+
+	//Client fire IDs that have not been acknowledged by the server yet (client prediction)
+	TArray<int16> PendingFireSimulationIDs;
+
+	//Hit prediction - hits shown on the client that wait for the servers verdict
+	TArray<FPredictedHit> PredictedHits;
+	TArray<FHitConfirmation> PendingHitConfirmations;	//Server, sent once per tick
+
+	//Projectile prediction - predicted copies waiting for the authoritative projectile or a rejection
+	TArray<TWeakObjectPtr<class AProjectile>> PredictedProjectiles;
+	TArray<int16> PendingRejectedProjectiles;	//Server, sent once per tick
+
+	//Reused by TraceShownHitboxes so tracing does not allocate
+	TArray<class APlayerCharacter*> HitboxCharacters;
+	TArray<FPlayerHitboxSet> HitboxSets;
+	TArray<const FPlayerHitboxSet*> HitboxSetPtrs;
+
+	FHitboxRay GetShotRay(const FVector& Start, const FVector& Direction) const;
+	bool VerifyHit(const FGunFireData& FireData, const FHitboxRay& ShotRay, class APlayerCharacter*& OutHitCharacter, FHitboxRayResult& OutResult) const;
+	void SendHitConfirmations();
+
+	bool SpawnPredictedProjectile();
+	bool SpawnAuthoritativeProjectile(const FGunFireData& FireData);
+	void SendProjectileRejections();
+	void ReleasePredictedProjectiles(bool bOnlyExpired);
+
+	UPROPERTY(ReplicatedUsing = OnRep_WeaponState)
+		FReplicatedWeaponState ReplicatedWeaponState;
+
+	UFUNCTION()
+		void OnRep_WeaponState();
+
+	void UpdateReplicatedWeaponState();
+	bool bIsWeaponStateDirty = false;	//Changed since the last replication, counted by the traffic stats once
 
 	//Networking Functions
 	UFUNCTION(Server, Unreliable, WithValidation)
 		void Server_SendGunFire(FGunFireData ClientFireData);
+	UFUNCTION(Server, Reliable, WithValidation)
+		void Server_SendReload(uint8 ClientReloadSequence);
+	UFUNCTION(Server, Reliable, WithValidation)
+		void Server_SendAimDownSights(bool bNewIsADS);
 	UFUNCTION(NetMulticast, Unreliable, WithValidation)
 		void MultiCastClient_ReplicateGunFireToClients();
-	UFUNCTION(Client, Unreliable, WithValidation)
-		void Client_CheckPlayerGunStats(FServerGunData ServerGunData);
+	UFUNCTION(Client, Reliable)
+		void Client_ConfirmHits(const TArray<FHitConfirmation>& Confirmations);
+	UFUNCTION(Client, Reliable)
+		void Client_RejectProjectiles(const TArray<int16>& PredictionIDs);
 
 
 public:	
@@ -86,10 +205,17 @@ public:
 
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
 	
 	// Called every frame
 	virtual void Tick( float DeltaSeconds ) override;
 
+	//Fires if the weapon can, UseItem stays free of side effects so Blueprints can call it next to the fire input
+	void Fire();
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "WeaponMesh")
 		USkeletalMeshComponent *WeaponMesh;
 
@@ -109,6 +235,33 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon|Damage")
 		float LegShotDamage;
 
+	float GetDamageForRegion(EHitboxRegion::Type Region) const;
+
+	//Traces the hitboxes of the characters where this machine shows them, used by shots & by projectiles for each flown segment
+	bool TraceShownHitboxes(const FHitboxRay& ShotRay, class APlayerCharacter*& OutHitCharacter, FHitboxRayResult& OutResult);
+
+	//Owning client - removes the predicted projectile of a fire ID from the weapon, nullptr if there is none
+	class AProjectile* TakePredictedProjectile(int16 PredictionID);
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon|Hit Prediction")
+		float Range = 10000;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon|Hit Prediction")
+		float MaxFireOriginError = 200;	//How far from the shooter the server accepts a shot to start
+
+	//Hit effects are played when the client predicts the hit, confirmed or rejected once the server has verified it
+	UFUNCTION(BlueprintImplementableEvent, Category = "Weapon|Hit Prediction")
+		void OnPredictedHit(APawn* HitPawn, FVector HitLocation, TEnumAsByte<EHitboxRegion::Type> Region);
+	UFUNCTION(BlueprintImplementableEvent, Category = "Weapon|Hit Prediction")
+		void OnHitConfirmed(APawn* HitPawn, TEnumAsByte<EHitboxRegion::Type> Region);
+	UFUNCTION(BlueprintImplementableEvent, Category = "Weapon|Hit Prediction")
+		void OnHitRejected(APawn* HitPawn);
+
+	//Weapons with a projectile class fire projectiles instead of hitscan shots
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon|Projectile")
+		TSubclassOf<class AProjectile> ProjectileClass;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon|Projectile")
+		float ProjectileSpeed = 5000;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon|Accurracy")
 		float DefaultHipFireInaccurracyAngle;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon|Accurracy")
@@ -120,6 +273,8 @@ public:
 		bool CanReloadSingleBullet = false;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon|Ammo")
 		int MaxClipAmmo;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon|Ammo")
+		float ReloadTime = 2;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon|Movement")
 		float MovementModifier;
@@ -138,4 +293,11 @@ public:
 		bool ThrowItem();
 		virtual bool ThrowItem_Implementation() override;
 
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "Actor Pool")
+		void OnAcquiredFromPool();
+		virtual void OnAcquiredFromPool_Implementation() override;
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "Actor Pool")
+		void OnReturnedToPool();
+		virtual void OnReturnedToPool_Implementation() override;
+
 };
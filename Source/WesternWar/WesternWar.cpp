@@ -3,3 +3,5 @@
 #include "WesternWar.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, WesternWar, "WesternWar" );
+
+DEFINE_LOG_CATEGORY(LogWesternWar);
@@ -4,3 +4,8 @@
 
 #include "Engine.h"
 
+DECLARE_LOG_CATEGORY_EXTERN(LogWesternWar, Log, All);
+
+//Netcode debug recording & drawing, compiled out of shipping & dedicated server builds
+#define WW_NETCODE_DEBUG (!UE_BUILD_SHIPPING && !UE_SERVER)
+